@@ -14,10 +14,48 @@ namespace rpc
 	Logger logger;
 	Profiler profiler;
 	Dispatch dispatch;
+	Decode decode;
+	Outbox outbox;
+	ShardDispatch shard;
+	BatchDispatch batch;
+	Coroutine coroutine;
+	Layout layout;
+	View view;
+	Traits traits;
+	Ping ping;
+	Bot bot;
+	Loopback loopback;
+	Compress compress;
+	Integrity integrity;
+	RateLimit rate_limit;
+	Trace trace;
+	ProxyCode proxy;
+	Gather gather;
+	SendQueue send_queue;
+	BatchEncode batch_encode;
+	Uring uring;
 	SerialBuffer serial_buffer;
 	Session session;
+	TypeMap type_map;
+	TypeId type_id;
 	Protocol protocol;
 
+	Protocol protocols[MAX_PROTOCOL_CNT];
+	int protocol_cnt = 0;
+	int group_cnt = 0;
+	int rate_slot_cnt = 0;
+	int shape_cnt = 0;
+	bool shape_body = false; // printing a shared encoder, the type is its parameter
+	bool defer_seal = false; // printing an encoder whose frame is sealed in send order later, by the send queue's IO thread or the outbox drain
+
+	ProfileEntry profile[MAX_PROTOCOL_CNT];
+	int profile_cnt = 0;
+	int hot_case[MAX_HOT_CASE]; // protocols index, hottest first
+	int hot_case_cnt = 0;
+	int cold_case_cnt = 0;
+	bool hot_likely = false; // the hottest type alone carries most of the side's traffic
+	bool string_stub[2] = {}; // a CS_ or SC_ message of protocol.txt carries a string, by the side whose stub handles it
+
 	FileInfo ssh; // server_stub_header
 	FileInfo ssc; // server_stub_cpp
 	FileInfo sph; // server_proxy_header
@@ -26,30 +64,147 @@ namespace rpc
 	FileInfo csc; // client_stub_cpp
 	FileInfo cph; // client_proxy_header
 	FileInfo cpc; // client_proxy_cpp
+	FileInfo obh; // outbox_header
+	FileInfo mqh; // mpsc_queue_header
+	FileInfo sdh; // shard_dispatcher_header
+	FileInfo tkh; // task_header
+	FileInfo vwh; // view_header
+	FileInfo trh; // traits_header
+	FileInfo gth; // gather_queue_header
+	FileInfo sqh; // send_queue_header
+	FileInfo bch; // batch_encode_header
+	FileInfo btc; // batch_test_cpp
+	FileInfo stc; // string_test_cpp
+	FileInfo igh; // integrity_header
+	FileInfo czh; // compress_header
+	FileInfo bth; // bot_harness_cpp
+	FileInfo lbc; // loopback_cpp
+	FileInfo pgh; // ping_header
+	FileInfo rlh; // rate_limit_header
+	FileInfo tch; // trace_header
+	FileInfo stm; // stream_dispatcher_header
+	FileInfo urh; // uring_transport_header
 
 	bool set_config();
+	bool load_profile();
+	bool set_type_map(const wchar_t* list);
+	bool copy_trimmed(wchar_t* dest, const wchar_t* src, int len);
 	bool create_file();
+	void scan_strings();
 
 	void parse();
 
 	bool parse_line(const wchar_t* line);
 	bool parse_protocol_type(const wchar_t* line);
 	bool parse_protocol(const wchar_t* line);
-
+	bool parse_attribute(const wchar_t* line);
+	bool set_attribute(const wchar_t* key, const wchar_t* value);
+	bool set_coalesce();
+	bool set_rate();
+	bool set_shape();
+	bool set_string(int param);
+	bool check_string();
+	bool map_type(int param);
+	void set_traffic();
+	void set_tier(int s_c);
+
+	int wire_size(const wchar_t* type);
 	int until(const wchar_t* line, const wchar_t* token);
 	int skip(const wchar_t* line, const wchar_t* token);
 
 	void print_header(FileInfo& header, FileInfo& cpp, int s_c, int s_p);
 	void print_namespace(FileInfo& header, FileInfo& cpp, int s_c);
 	void print_class(FileInfo& header, int s_p);
-	void print_dispatch_stub(FileInfo& header, FileInfo& cpp);
+	void print_dispatch_stub(FileInfo& header);
+	void print_dispatch_body(FileInfo& cpp);
+	void print_dispatch_compressed(FileInfo& cpp);
+	void print_dispatch_bound(FileInfo& cpp);
+	void print_dispatch_rate(FileInfo& cpp);
+	void print_dispatch_hot(FileInfo& cpp);
+	void print_dispatch_switch(FileInfo& cpp);
+	void print_dispatch_call(FileInfo& cpp, const Protocol& info, bool member);
+	void print_dispatch_miss(FileInfo& cpp);
+	void print_dispatch_cold(FileInfo& cpp);
+	void print_dispatch_lookup(FileInfo& cpp);
+	void print_dispatch_table(FileInfo& cpp);
+	void print_dispatch_pages(FileInfo& cpp, const wchar_t* declaration, const int* page_hi, int page_cnt, int kind);
+	void print_dispatch_page(FileInfo& cpp, int hi, int kind);
+	void print_batch_stub(FileInfo& header);
+	void print_batch_queue(FileInfo& cpp);
+	void print_batch_body(FileInfo& cpp);
+	void print_decoder(FileInfo& cpp, const Protocol& info);
+	void print_string_decode(FileInfo& cpp, const Protocol& info);
 	void print_protocol();
-	void print_protocol_stub(FileInfo& header, FileInfo& cpp);
+	void print_protocol_stub(FileInfo& header);
 	void print_protocol_proxy(FileInfo& header, FileInfo& cpp);
+	void print_protocol_span(FileInfo& header, FileInfo& cpp);
+	void print_protocol_gather(FileInfo& header, FileInfo& cpp);
+	void print_buffer_body(FileInfo& body);
+	void print_span_body(FileInfo& body);
+	void print_gather_body(FileInfo& body);
+	void print_protocol_send(FileInfo& header, FileInfo& cpp);
+	void print_protocol_batch(FileInfo& header, FileInfo& cpp);
+	void print_batch_plan(FileInfo& cpp, int frame_size);
+	void print_batch_signature(FileInfo& info, bool definition);
+	void print_shape(FileInfo& cpp);
+	void print_shape_call(FileInfo& body, const wchar_t* prefix, const wchar_t* first_name);
+	void print_type_term(FileInfo& body);
+	void print_proxy_signature(FileInfo& header, FileInfo& body, const wchar_t* result, const wchar_t* first_type, const wchar_t* first_name);
+	void print_frame_copy(FileInfo& cpp);
+	void print_header_term(FileInfo& body);
+	void print_string_length(FileInfo& body, bool payload);
+	void print_string_term(FileInfo& body, int param_end);
+	void print_direct_seal(FileInfo& cpp, const wchar_t* guard, const wchar_t* buffer, const wchar_t* access);
+	void print_guard_seal(FileInfo& cpp, const wchar_t* frame, const wchar_t* size_name, int size);
+	void print_packed_buffer(FileInfo& cpp);
 	void print_close();
 	void print_close_stub(FileInfo& header, FileInfo& cpp);
 	void print_close_proxy(FileInfo& header, FileInfo& cpp);
 	void print_tab(FileInfo& info);
+	void print_lines(FileInfo& info, const wchar_t* const* lines, int line_cnt);
+
+	bool open_shared(FileInfo& info, const wchar_t* part, int h_c);
+	void print_shared_namespace(FileInfo& info);
+	void print_shared_close(FileInfo& info);
+	void print_outbox(FileInfo& header);
+	void print_mpsc(FileInfo& header);
+	void print_shard(FileInfo& header);
+	void print_task(FileInfo& header);
+	void print_view(FileInfo& header);
+	void print_traits(FileInfo& header);
+	void print_gather(FileInfo& header);
+	void print_send_queue(FileInfo& header);
+	void print_batch_kernel(FileInfo& header);
+	void print_batch_test(FileInfo& cpp);
+	void print_string_test(FileInfo& cpp);
+	void print_string_check(FileInfo& cpp, int s_c);
+	void print_bot(FileInfo& cpp);
+	void print_bot_hook(FileInfo& cpp);
+	void print_bot_stub(FileInfo& cpp, int reply);
+	void print_bot_mix(FileInfo& cpp, int request, const wchar_t* clock, const wchar_t* unit, const wchar_t* guard);
+	void print_loopback(FileInfo& cpp);
+	void print_loopback_stub(FileInfo& cpp, int s_c, int request, int reply);
+	void print_loopback_hook(FileInfo& cpp);
+	void print_compress(FileInfo& header);
+	void print_ping(FileInfo& header);
+	void print_rate(FileInfo& header);
+	void print_trace(FileInfo& header);
+	void print_trace_encode(FileInfo& body, const wchar_t* frame, const wchar_t* size_name, int size);
+	void print_integrity(FileInfo& header);
+	void print_stream(FileInfo& header);
+	void print_uring(FileInfo& header);
+
+	bool is_stub_of(const Protocol& info, int s_c);
+	bool is_packed(const Protocol& info);
+	bool is_batched(const Protocol& info);
+	bool is_batch_encoded(const Protocol& info);
+	bool is_rated(int s_c);
+	bool is_same_shape(const Protocol& a, const Protocol& b);
+	bool is_batch_side(int s_c);
+	bool has_string(const Protocol& info);
+	bool is_used(const wchar_t* expression, const wchar_t* name);
+	bool is_sized(int s_c);
+	bool has_cold_path();
 
 	void generate()
 	{
@@ -112,6 +267,30 @@ namespace rpc
 					break;
 				}
 
+				if (!config.fill(L"protocol.type.bits", &type_id.bits))
+				{
+					wprintf(L"failed fill protocol.type.bits\n");
+					break;
+				}
+
+				if (type_id.bits == 8)
+				{
+					wcscpy_s(type_id.name, BUFFER_SIZE, L"unsigned char");
+					type_id.max = 0xFF;
+				}
+				else if (type_id.bits == 16)
+				{
+					wcscpy_s(type_id.name, BUFFER_SIZE, L"unsigned short");
+					type_id.max = 0xFFFF;
+				}
+				else
+				{
+					wprintf(L"protocol.type.bits must be 8 or 16\n");
+					break;
+				}
+
+				type_id.header_size = 2 + type_id.bits / 8; // code + size + type
+
 				if (!config.fill(L"dispatch.profiler.enable", &profiler.enable))
 				{
 					wprintf(L"failed fill dispatch.profiler.enable\n");
@@ -126,7 +305,7 @@ namespace rpc
 						break;
 					}
 
-					if (!config.fill(L"dispatch.profiler.expression", profiler.expression, BUFFER_SIZE))
+					if (!config.fill(L"dispatch.profiler.expression", profiler.expression, EXPRESSION_SIZE))
 					{
 						wprintf(L"failed fill dispatch.profiler.expression\n");
 						break;
@@ -171,7 +350,7 @@ namespace rpc
 
 				if (dispatch.enable_weird_type)
 				{
-					if (!config.fill(L"dispatch.log.weird type.expression", dispatch.weird_type, BUFFER_SIZE))
+					if (!config.fill(L"dispatch.log.weird type.expression", dispatch.weird_type, EXPRESSION_SIZE))
 					{
 						wprintf(L"failed fill dispatch.log.weird type.expression\n");
 						break;
@@ -186,792 +365,10587 @@ namespace rpc
 
 				if (dispatch.enable_exception)
 				{
-					if (!config.fill(L"dispatch.log.exception.expression", dispatch.exception, BUFFER_SIZE))
+					if (!config.fill(L"dispatch.log.exception.expression", dispatch.exception, EXPRESSION_SIZE))
 					{
 						wprintf(L"failed fill dispatch.log.exception.expression\n");
 						break;
 					}
 				}
 
-				if (!config.fill(L"serial buffer.header", serial_buffer.header, BUFFER_SIZE))
+				if (!config.fill(L"dispatch.log.bad size.enable", &dispatch.enable_bad_size))
 				{
-					wprintf(L"failed fill serial buffer.header\n");
+					wprintf(L"failed fill dispatch.log.bad size.enable\n");
 					break;
 				}
 
-				if (!config.fill(L"serial buffer.type", serial_buffer.type, BUFFER_SIZE))
+				if (dispatch.enable_bad_size)
 				{
-					wprintf(L"failed fill serial buffer.type\n");
-					break;
+					if (!config.fill(L"dispatch.log.bad size.expression", dispatch.bad_size, EXPRESSION_SIZE))
+					{
+						wprintf(L"failed fill dispatch.log.bad size.expression\n");
+						break;
+					}
 				}
 
-				if (!config.fill(L"serial buffer.parameter", serial_buffer.param, BUFFER_SIZE))
+				if (!config.fill(L"dispatch.decode.enable", &decode.enable))
 				{
-					wprintf(L"failed fill serial buffer.parameter\n");
+					wprintf(L"failed fill dispatch.decode.enable\n");
 					break;
 				}
 
-				if (!config.fill(L"session.header", session.header, BUFFER_SIZE))
+				if (!config.fill(L"dispatch.view.enable", &view.enable))
 				{
-					wprintf(L"failed fill session.header\n");
+					wprintf(L"failed fill dispatch.view.enable\n");
 					break;
 				}
 
-				if (!config.fill(L"session.type", session.type, BUFFER_SIZE))
+				if (view.enable && !decode.enable)
 				{
-					wprintf(L"failed fill session.type\n");
+					wprintf(L"dispatch.view needs dispatch.decode\n");
 					break;
 				}
 
-				if (!config.fill(L"session.parameter", session.param, BUFFER_SIZE))
+				if (!config.fill(L"dispatch.shard.enable", &shard.enable))
 				{
-					wprintf(L"failed fill session.parameter\n");
+					wprintf(L"failed fill dispatch.shard.enable\n");
 					break;
 				}
 
-				if (!config.fill(L"session.header.prefix.enable_global", &session.global_prefix))
+				if (shard.enable)
 				{
-					wprintf(L"failed fill session.header.prefix.enable_global\n");
-					break;
+					if (!config.fill(L"dispatch.shard.batch", &shard.batch))
+					{
+						wprintf(L"failed fill dispatch.shard.batch\n");
+						break;
+					}
+
+					if (!decode.enable)
+					{
+						wprintf(L"dispatch.shard needs dispatch.decode\n");
+						break;
+					}
 				}
 
-				if (!config.fill(L"session.header.prefix.enable_side", &session.side_prefix))
+				if (!config.fill(L"dispatch.batch.enable", &batch.enable))
 				{
-					wprintf(L"failed fill session.header.prefix.enable_side\n");
+					wprintf(L"failed fill dispatch.batch.enable\n");
 					break;
 				}
 
-				return true;
-			} while (false);
+				if (batch.enable)
+				{
+					if (!config.fill(L"dispatch.batch.capacity", &batch.capacity))
+					{
+						wprintf(L"failed fill dispatch.batch.capacity\n");
+						break;
+					}
 
-			return false;
-		}
-		catch (std::runtime_error& e)
-		{
-			wprintf(L"error caught: %hs\n", e.what());
-			return false;
-		}
-	}
+					if (batch.capacity <= 0)
+					{
+						wprintf(L"dispatch.batch.capacity must be positive\n");
+						break;
+					}
 
-	bool create_file()
-	{
-		FileInfo* file_info[2][2][2] =
-		{
-			{{&ssh,&ssc},
-			{&sph,&spc}},
-			{{&csh,&csc},
-			{&cph,&cpc}}
-		};
+					// a shard worker has no tick to flush at
+					if (!decode.enable || shard.enable)
+					{
+						wprintf(L"dispatch.batch needs dispatch.decode without dispatch.shard\n");
+						break;
+					}
+				}
 
-		for (int s_c = 0; s_c < 2; ++s_c)
-		{
-			if (s_c == SERVER && !creation.server_side)
-			{
-				continue;
-			}
+				if (decode.enable)
+				{
+					if (!config.fill(L"dispatch.decode.string_test", &decode.string_test))
+					{
+						wprintf(L"failed fill dispatch.decode.string_test\n");
+						break;
+					}
 
-			if (s_c == CLIENT && !creation.client_side)
-			{
-				continue;
-			}
+					// one proxy encodes, the other side's stub decodes on the same thread, both in one translation unit
+					if (decode.string_test && (!creation.server_side || !creation.client_side || !ns.enable_side || batch.enable))
+					{
+						wprintf(L"dispatch.decode.string_test needs both file.creation sides and namespace.side without dispatch.batch\n");
+						break;
+					}
+				}
 
-			for (int s_p = 0; s_p < 2; ++s_p)
-			{
-				FileInfo* head = file_info[s_c][s_p][HEADER];
-				FileInfo* cpp = file_info[s_c][s_p][CPP];
+				if (!config.fill(L"dispatch.coroutine.enable", &coroutine.enable))
+				{
+					wprintf(L"failed fill dispatch.coroutine.enable\n");
+					break;
+				}
 
-				head->s_c = s_c;
-				cpp->s_c = s_c;
+				if (coroutine.enable)
+				{
+					if (!config.fill(L"dispatch.coroutine.frame_block", &coroutine.block_size))
+					{
+						wprintf(L"failed fill dispatch.coroutine.frame_block\n");
+						break;
+					}
+				}
 
-				head->s_p = s_p;
-				cpp->s_p = s_p;
+				if (!config.fill(L"dispatch.layout.enable", &layout.enable))
+				{
+					wprintf(L"failed fill dispatch.layout.enable\n");
+					break;
+				}
 
-				head->h_c = HEADER;
-				cpp->h_c = CPP;
+				if (layout.enable)
+				{
+					if (!config.fill(L"dispatch.layout.profile", layout.profile, BUFFER_SIZE))
+					{
+						wprintf(L"failed fill dispatch.layout.profile\n");
+						break;
+					}
 
-				head->filename[0] = L'\0';
-				cpp->filename[0] = L'\0';
+					if (!config.fill(L"dispatch.layout.hot", &layout.hot))
+					{
+						wprintf(L"failed fill dispatch.layout.hot\n");
+						break;
+					}
 
-				if (creation.global_prefix)
+					if (!config.fill(L"dispatch.layout.cold", &layout.cold))
+					{
+						wprintf(L"failed fill dispatch.layout.cold\n");
+						break;
+					}
+
+					if (layout.hot < 0 || layout.hot > 100 || layout.cold < 0 || layout.cold > 1000000)
+					{
+						wprintf(L"dispatch.layout.hot must be 0 to 100, dispatch.layout.cold 0 to 1000000\n");
+						break;
+					}
+
+					if (!load_profile())
+					{
+						break;
+					}
+				}
+
+				if (!config.fill(L"traits.enable", &traits.enable))
 				{
-					wcscat_s(head->filename, FILENAME_MAX, ns.global);
-					wcscat_s(head->filename, FILENAME_MAX, L"_");
-					wcscat_s(cpp->filename, FILENAME_MAX, ns.global);
-					wcscat_s(cpp->filename, FILENAME_MAX, L"_");
+					wprintf(L"failed fill traits.enable\n");
+					break;
 				}
 
-				if (creation.side_prefix)
+				if (!config.fill(L"integrity.enable", &integrity.enable))
 				{
-					wcscat_s(head->filename, FILENAME_MAX, RPC_SIDE[s_c]);
-					wcscat_s(head->filename, FILENAME_MAX, L"_");
-					wcscat_s(cpp->filename, FILENAME_MAX, RPC_SIDE[s_c]);
-					wcscat_s(cpp->filename, FILENAME_MAX, L"_");
+					wprintf(L"failed fill integrity.enable\n");
+					break;
 				}
 
-				wcscat_s(head->filename, FILENAME_MAX, RPC_PART[s_p]);
-				wcscat_s(cpp->filename, FILENAME_MAX, RPC_PART[s_p]);
+				if (integrity.enable && !decode.enable)
+				{
+					wprintf(L"integrity needs dispatch.decode\n");
+					break;
+				}
 
-				wcscat_s(head->filename, FILENAME_MAX, EXTENSION[HEADER]);
-				wcscat_s(cpp->filename, FILENAME_MAX, EXTENSION[CPP]);
+				integrity.trailer_size = integrity.enable ? TRAILER_SIZE : 0;
 
-				if (_wfopen_s(&head->file, head->filename, L"wt, ccs=UNICODE") != 0 ||
-					head->file == nullptr)
+				if (!config.fill(L"compress.enable", &compress.enable))
 				{
-					return false;
+					wprintf(L"failed fill compress.enable\n");
+					break;
 				}
 
-				if (_wfopen_s(&cpp->file, cpp->filename, L"wt, ccs=UNICODE") != 0 ||
-					cpp->file == nullptr)
+				if (compress.enable)
 				{
-					return false;
-				}
+					if (!config.fill(L"compress.threshold", &compress.threshold))
+					{
+						wprintf(L"failed fill compress.threshold\n");
+						break;
+					}
 
-				print_header(*head, *cpp, s_c, s_p);
+					if (compress.threshold < 0 || compress.threshold > 254)
+					{
+						wprintf(L"compress.threshold must be 0 to 254\n");
+						break;
+					}
 
-				if (ns.enable || ns.enable_side)
+					if (!decode.enable)
+					{
+						wprintf(L"compress needs dispatch.decode\n");
+						break;
+					}
+				}
+
+				if (!config.fill(L"rate_limit.enable", &rate_limit.enable))
 				{
-					print_namespace(*head, *cpp, s_c);
+					wprintf(L"failed fill rate_limit.enable\n");
+					break;
 				}
 
-				print_class(*head, s_p);
+				if (rate_limit.enable)
+				{
+					if (!config.fill(L"rate_limit.disconnect", &rate_limit.disconnect))
+					{
+						wprintf(L"failed fill rate_limit.disconnect\n");
+						break;
+					}
+				}
 
-				if (s_p == STUB)
+				if (!config.fill(L"trace.enable", &trace.enable))
 				{
-					print_dispatch_stub(*head, *cpp);
+					wprintf(L"failed fill trace.enable\n");
+					break;
 				}
-			}
-		}
 
-		return true;
-	}
+				if (trace.enable)
+				{
+					if (!config.fill(L"trace.provider", trace.provider, BUFFER_SIZE))
+					{
+						wprintf(L"failed fill trace.provider\n");
+						break;
+					}
 
-	void parse()
-	{
-		FILE* file = nullptr;
-		if (_wfopen_s(&file, L"rpc/protocol.txt", L"rt, ccs=UNICODE") != 0 || file == nullptr)
-		{
-			wprintf(L"failed to open ./rpc/protocol.txt\n");
-			return;
-		}
+					// the provider is pasted into symbol names and probe notes
+					size_t provider_len = wcslen(trace.provider);
+					if (provider_len == 0 || (trace.provider[0] >= L'0' && trace.provider[0] <= L'9') ||
+						wcsspn(trace.provider, L"abcdefghijklmnopqrstuvwxyz0123456789_") != provider_len)
+					{
+						wprintf(L"trace.provider must be a lower-case identifier\n");
+						break;
+					}
 
-		wchar_t line[FILENAME_MAX];
-		while (fgetws(line, FILENAME_MAX, file))
-		{
-			if (!parse_line(line))
-			{
-				break;
-			}
-		}
+					for (size_t i = 0; i <= provider_len; ++i)
+					{
+						trace.prefix[i] = towupper(trace.provider[i]);
+					}
+				}
 
-		print_close();
+				if (!config.fill(L"proxy.inline", &proxy.inline_body))
+				{
+					wprintf(L"failed fill proxy.inline\n");
+					break;
+				}
 
-		fclose(file);
-	}
+				if (!config.fill(L"proxy.shared", &proxy.shared))
+				{
+					wprintf(L"failed fill proxy.shared\n");
+					break;
+				}
 
-	bool parse_line(const wchar_t* line)
-	{
-		int pos = skip(line, L" \t\r\n");
-		if (pos == -1)
-		{
-			return true;
-		}
+				// inline bodies are meant to be copied into call sites, shared ones to exist once
+				if (proxy.shared && proxy.inline_body)
+				{
+					wprintf(L"proxy.shared and proxy.inline exclude each other\n");
+					break;
+				}
 
-		if (wcsncmp(line + pos, L"TYPE", 4) == 0)
-		{
-			return parse_protocol_type(line + pos + 4);
-		}
-		else
-		{
-			return parse_protocol(line + pos);
-		}
+				if (!config.fill(L"proxy.gather.enable", &gather.enable))
+				{
+					wprintf(L"failed fill proxy.gather.enable\n");
+					break;
+				}
 
-		return false;
-	}
+				if (gather.enable)
+				{
+					if (!config.fill(L"proxy.gather.chunk_size", &gather.chunk_size))
+					{
+						wprintf(L"failed fill proxy.gather.chunk_size\n");
+						break;
+					}
 
-	bool parse_protocol_type(const wchar_t* line)
-	{
-		int pos = skip(line, L" \t=");
-		if (pos == -1)
-		{
-			return false;
+					if (gather.chunk_size < type_id.header_size + 255 + integrity.trailer_size)
+					{
+						wprintf(L"proxy.gather.chunk_size must hold a whole frame\n");
+						break;
+					}
+				}
+
+				if (!config.fill(L"proxy.send_queue.enable", &send_queue.enable))
+				{
+					wprintf(L"failed fill proxy.send_queue.enable\n");
+					break;
+				}
+
+				if (send_queue.enable)
+				{
+					if (!config.fill(L"proxy.send_queue.batch", &send_queue.batch))
+					{
+						wprintf(L"failed fill proxy.send_queue.batch\n");
+						break;
+					}
+
+					if (send_queue.batch <= 0)
+					{
+						wprintf(L"proxy.send_queue.batch must be positive\n");
+						break;
+					}
+				}
+
+				if (!config.fill(L"proxy.batch.enable", &batch_encode.enable))
+				{
+					wprintf(L"failed fill proxy.batch.enable\n");
+					break;
+				}
+
+				if (batch_encode.enable)
+				{
+					if (!config.fill(L"proxy.batch.test", &batch_encode.test))
+					{
+						wprintf(L"failed fill proxy.batch.test\n");
+						break;
+					}
+
+					// the test holds both proxies in one translation unit
+					if (batch_encode.test && creation.server_side && creation.client_side && !ns.enable_side)
+					{
+						wprintf(L"proxy.batch.test with both file.creation sides needs namespace.side\n");
+						break;
+					}
+				}
+
+				if (!config.fill(L"transport.uring.enable", &uring.enable))
+				{
+					wprintf(L"failed fill transport.uring.enable\n");
+					break;
+				}
+
+				if (uring.enable)
+				{
+					if (!config.fill(L"transport.uring.entries", &uring.entries))
+					{
+						wprintf(L"failed fill transport.uring.entries\n");
+						break;
+					}
+
+					if (!config.fill(L"transport.uring.buffer_cnt", &uring.buffer_cnt))
+					{
+						wprintf(L"failed fill transport.uring.buffer_cnt\n");
+						break;
+					}
+
+					if (!config.fill(L"transport.uring.buffer_size", &uring.buffer_size))
+					{
+						wprintf(L"failed fill transport.uring.buffer_size\n");
+						break;
+					}
+
+					// provided buffer rings are indexed with a mask
+					if (uring.buffer_cnt <= 0 || uring.buffer_cnt > 32768 || (uring.buffer_cnt & (uring.buffer_cnt - 1)) != 0)
+					{
+						wprintf(L"transport.uring.buffer_cnt must be a power of two up to 32768\n");
+						break;
+					}
+
+					if (uring.buffer_size < type_id.header_size + 255 + integrity.trailer_size)
+					{
+						wprintf(L"transport.uring.buffer_size must hold a whole frame\n");
+						break;
+					}
+
+					if (!decode.enable)
+					{
+						wprintf(L"transport.uring needs dispatch.decode\n");
+						break;
+					}
+				}
+
+				if (!config.fill(L"ping.enable", &ping.enable))
+				{
+					wprintf(L"failed fill ping.enable\n");
+					break;
+				}
+
+				if (ping.enable)
+				{
+					if (!config.fill(L"ping.request_type", &ping.request_type))
+					{
+						wprintf(L"failed fill ping.request_type\n");
+						break;
+					}
+
+					if (!config.fill(L"ping.reply_type", &ping.reply_type))
+					{
+						wprintf(L"failed fill ping.reply_type\n");
+						break;
+					}
+
+					if (ping.request_type < 0 || ping.request_type > type_id.max || ping.reply_type < 0 || ping.reply_type > type_id.max ||
+						ping.request_type == ping.reply_type)
+					{
+						wprintf(L"ping.request_type and ping.reply_type must be two distinct protocol types\n");
+						break;
+					}
+
+					if (!decode.enable)
+					{
+						wprintf(L"ping needs dispatch.decode\n");
+						break;
+					}
+				}
+
+				if (!config.fill(L"bot.enable", &bot.enable))
+				{
+					wprintf(L"failed fill bot.enable\n");
+					break;
+				}
+
+				if (bot.enable)
+				{
+					if (!config.fill(L"bot.request", bot.request, BUFFER_SIZE))
+					{
+						wprintf(L"failed fill bot.request\n");
+						break;
+					}
+
+					if (!config.fill(L"bot.reply", bot.reply, BUFFER_SIZE))
+					{
+						wprintf(L"failed fill bot.reply\n");
+						break;
+					}
+
+					if (!config.fill(L"bot.port", &bot.port))
+					{
+						wprintf(L"failed fill bot.port\n");
+						break;
+					}
+
+					if (!config.fill(L"bot.clients", &bot.clients))
+					{
+						wprintf(L"failed fill bot.clients\n");
+						break;
+					}
+
+					if (!config.fill(L"bot.seconds", &bot.seconds))
+					{
+						wprintf(L"failed fill bot.seconds\n");
+						break;
+					}
+
+					if (!config.fill(L"bot.rate", &bot.rate))
+					{
+						wprintf(L"failed fill bot.rate\n");
+						break;
+					}
+
+					// bots drive the client side: its proxies encode, its stub reads the replies
+					if (!creation.client_side || !decode.enable || coroutine.enable)
+					{
+						wprintf(L"bot needs file.creation.client_side and dispatch.decode without dispatch.coroutine\n");
+						break;
+					}
+
+					// its stub counts and times one frame at a time
+					if (batch.enable)
+					{
+						wprintf(L"bot excludes dispatch.batch\n");
+						break;
+					}
+				}
+
+				if (!config.fill(L"loopback.enable", &loopback.enable))
+				{
+					wprintf(L"failed fill loopback.enable\n");
+					break;
+				}
+
+				if (loopback.enable)
+				{
+					if (!config.fill(L"loopback.request", loopback.request, BUFFER_SIZE))
+					{
+						wprintf(L"failed fill loopback.request\n");
+						break;
+					}
+
+					if (!config.fill(L"loopback.reply", loopback.reply, BUFFER_SIZE))
+					{
+						wprintf(L"failed fill loopback.reply\n");
+						break;
+					}
+
+					if (!config.fill(L"loopback.messages", &loopback.messages))
+					{
+						wprintf(L"failed fill loopback.messages\n");
+						break;
+					}
+
+					if (!config.fill(L"loopback.ring", &loopback.ring))
+					{
+						wprintf(L"failed fill loopback.ring\n");
+						break;
+					}
+
+					if (loopback.messages <= 0 || loopback.ring < 1024 || (loopback.ring & (loopback.ring - 1)) != 0)
+					{
+						wprintf(L"loopback.messages must be positive, loopback.ring a power of two of at least 1024\n");
+						break;
+					}
+
+					// both sides meet in one translation unit, so their classes have to live apart
+					if (!creation.server_side || !creation.client_side || !ns.enable_side || !decode.enable || coroutine.enable)
+					{
+						wprintf(L"loopback needs both file.creation sides, namespace.side and dispatch.decode without dispatch.coroutine\n");
+						break;
+					}
+
+					// its stubs answer and count one frame at a time
+					if (batch.enable)
+					{
+						wprintf(L"loopback excludes dispatch.batch\n");
+						break;
+					}
+				}
+
+				if (!config.fill(L"outbox.enable", &outbox.enable))
+				{
+					wprintf(L"failed fill outbox.enable\n");
+					break;
+				}
+
+				if (outbox.enable)
+				{
+					if (!config.fill(L"outbox.drop_threshold", &outbox.drop_threshold))
+					{
+						wprintf(L"failed fill outbox.drop_threshold\n");
+						break;
+					}
+				}
+
+				if (!config.fill(L"serial buffer.header", serial_buffer.header, BUFFER_SIZE))
+				{
+					wprintf(L"failed fill serial buffer.header\n");
+					break;
+				}
+
+				if (!config.fill(L"serial buffer.type", serial_buffer.type, BUFFER_SIZE))
+				{
+					wprintf(L"failed fill serial buffer.type\n");
+					break;
+				}
+
+				if (!config.fill(L"serial buffer.parameter", serial_buffer.param, BUFFER_SIZE))
+				{
+					wprintf(L"failed fill serial buffer.parameter\n");
+					break;
+				}
+
+				if (!config.fill(L"serial buffer.put_data", serial_buffer.put_data, BUFFER_SIZE))
+				{
+					wprintf(L"failed fill serial buffer.put_data\n");
+					break;
+				}
+
+				if (!config.fill(L"session.header", session.header, BUFFER_SIZE))
+				{
+					wprintf(L"failed fill session.header\n");
+					break;
+				}
+
+				if (!config.fill(L"session.type", session.type, BUFFER_SIZE))
+				{
+					wprintf(L"failed fill session.type\n");
+					break;
+				}
+
+				if (!config.fill(L"session.parameter", session.param, BUFFER_SIZE))
+				{
+					wprintf(L"failed fill session.parameter\n");
+					break;
+				}
+
+				if (!config.fill(L"session.header.prefix.enable_global", &session.global_prefix))
+				{
+					wprintf(L"failed fill session.header.prefix.enable_global\n");
+					break;
+				}
+
+				if (!config.fill(L"session.header.prefix.enable_side", &session.side_prefix))
+				{
+					wprintf(L"failed fill session.header.prefix.enable_side\n");
+					break;
+				}
+
+				if (!config.fill(L"type map.enable", &type_map.enable))
+				{
+					wprintf(L"failed fill type map.enable\n");
+					break;
+				}
+
+				if (type_map.enable)
+				{
+					wchar_t list[LIST_SIZE];
+					if (!config.fill(L"type map.types", list, LIST_SIZE))
+					{
+						wprintf(L"failed fill type map.types\n");
+						break;
+					}
+
+					if (!set_type_map(list))
+					{
+						break;
+					}
+				}
+
+				if (!config.fill(L"type map.forward_declare", &type_map.forward_declare))
+				{
+					wprintf(L"failed fill type map.forward_declare\n");
+					break;
+				}
+
+				return true;
+			} while (false);
+
+			return false;
+		}
+		catch (std::runtime_error& e)
+		{
+			wprintf(L"error caught: %hs\n", e.what());
+			return false;
+		}
+	}
+
+	// NAME = count per line, from captured traffic or exported per-type counters, a decimal type works as a name
+	bool load_profile()
+	{
+		FILE* file = nullptr;
+		if (_wfopen_s(&file, layout.profile, L"rt, ccs=UNICODE") != 0 || file == nullptr)
+		{
+			wprintf(L"failed to open %s\n", layout.profile);
+			return false;
+		}
+
+		bool loaded = true;
+
+		wchar_t line[FILENAME_MAX];
+		while (fgetws(line, FILENAME_MAX, file))
+		{
+			int pos = skip(line, L" \t\r\n");
+			if (pos == -1 || wcsncmp(line + pos, L"//", 2) == 0)
+			{
+				continue;
+			}
+
+			int len = until(line + pos, L" \t=\r\n");
+			int value = skip(line + pos + len, L" \t=");
+
+			if (len >= BUFFER_SIZE || value == -1 || !iswdigit(line[pos + len + value]) || profile_cnt == MAX_PROTOCOL_CNT)
+			{
+				wprintf(L"bad profile line: %.*s\n", until(line + pos, L"\r\n"), line + pos);
+				loaded = false;
+				break;
+			}
+
+			ProfileEntry& entry = profile[profile_cnt++];
+			wcsncpy_s(entry.name, BUFFER_SIZE, line + pos, len);
+			entry.name[len] = L'\0';
+			entry.count = wcstod(line + pos + len + value, nullptr);
+			entry.used = false;
+		}
+
+		fclose(file);
+
+		return loaded;
+	}
+
+	// schema:fixed pairs separated by commas, "unsigned short:uint16_t, DWORD:uint32_t"
+	bool set_type_map(const wchar_t* list)
+	{
+		type_map.cnt = 0;
+
+		for (int pos = 0; list[pos]; )
+		{
+			int len = until(list + pos, L",");
+			int split = until(list + pos, L":");
+
+			wchar_t* from = type_map.from[type_map.cnt];
+			wchar_t* to = type_map.to[type_map.cnt];
+
+			if (split >= len || type_map.cnt == MAX_TYPE_MAP_CNT ||
+				!copy_trimmed(from, list + pos, split) || !copy_trimmed(to, list + pos + split + 1, len - split - 1))
+			{
+				wprintf(L"bad type map entry: %.*s\n", len, list + pos);
+				return false;
+			}
+
+			if (wire_size(to) == -1 || wcscmp(to, L"wchar_t") == 0)
+			{
+				wprintf(L"type map target has no fixed size: %s:%s\n", from, to);
+				return false;
+			}
+
+			++type_map.cnt;
+
+			pos += list[pos + len] ? len + 1 : len;
+		}
+
+		return true;
+	}
+
+	// len characters without the blanks around them, false when nothing or too much is left
+	bool copy_trimmed(wchar_t* dest, const wchar_t* src, int len)
+	{
+		while (len > 0 && (*src == L' ' || *src == L'\t'))
+		{
+			++src;
+			--len;
+		}
+
+		while (len > 0 && (src[len - 1] == L' ' || src[len - 1] == L'\t'))
+		{
+			--len;
+		}
+
+		if (len == 0 || len >= BUFFER_SIZE)
+		{
+			return false;
+		}
+
+		wcsncpy_s(dest, BUFFER_SIZE, src, len);
+		dest[len] = L'\0';
+
+		return true;
+	}
+
+	// headers are written before parsing, so a first look at protocol.txt tells them whether to include <string_view>
+	void scan_strings()
+	{
+		FILE* file = nullptr;
+		if (_wfopen_s(&file, L"rpc/protocol.txt", L"rt, ccs=UNICODE") != 0 || file == nullptr)
+		{
+			return;
+		}
+
+		wchar_t line[FILENAME_MAX];
+		while (fgetws(line, FILENAME_MAX, file))
+		{
+			int pos = skip(line, L" \t\r\n");
+			if (pos == -1 || wcsncmp(line + pos, L"TYPE", 4) == 0 || wcsstr(line + pos, L"string<") == nullptr)
+			{
+				continue;
+			}
+
+			string_stub[line[pos] == L'S' ? CLIENT : SERVER] = true;
+		}
+
+		fclose(file);
+	}
+
+	bool create_file()
+	{
+		FileInfo* file_info[2][2][2] =
+		{
+			{{&ssh,&ssc},
+			{&sph,&spc}},
+			{{&csh,&csc},
+			{&cph,&cpc}}
+		};
+
+		if (decode.enable)
+		{
+			scan_strings();
+		}
+
+		if (shard.enable || send_queue.enable)
+		{
+			if (!open_shared(mqh, L"mpsc", HEADER))
+			{
+				return false;
+			}
+
+			print_mpsc(mqh);
+		}
+
+		if (shard.enable)
+		{
+			if (!open_shared(sdh, L"shard", HEADER))
+			{
+				return false;
+			}
+
+			print_shard(sdh);
+		}
+
+		if (coroutine.enable)
+		{
+			if (!open_shared(tkh, L"task", HEADER))
+			{
+				return false;
+			}
+
+			print_task(tkh);
+		}
+
+		if (view.enable) // filled at close, once every message is known
+		{
+			if (!open_shared(vwh, L"view", HEADER))
+			{
+				return false;
+			}
+		}
+
+		if (traits.enable)
+		{
+			if (!open_shared(trh, L"traits", HEADER))
+			{
+				return false;
+			}
+		}
+
+		if (gather.enable)
+		{
+			if (!open_shared(gth, L"gather", HEADER))
+			{
+				return false;
+			}
+
+			print_gather(gth);
+		}
+
+		if (compress.enable)
+		{
+			if (!open_shared(czh, L"compress", HEADER))
+			{
+				return false;
+			}
+
+			print_compress(czh);
+		}
+
+		if (integrity.enable)
+		{
+			if (!open_shared(igh, L"integrity", HEADER))
+			{
+				return false;
+			}
+
+			print_integrity(igh);
+		}
+
+		if (outbox.enable) // after integrity, whose header it includes
+		{
+			if (!open_shared(obh, L"outbox", HEADER))
+			{
+				return false;
+			}
+
+			print_outbox(obh);
+		}
+
+		if (send_queue.enable) // after integrity, whose header it includes
+		{
+			if (!open_shared(sqh, L"send_queue", HEADER))
+			{
+				return false;
+			}
+
+			print_send_queue(sqh);
+		}
+
+		if (batch_encode.enable)
+		{
+			if (!open_shared(bch, L"batch", HEADER))
+			{
+				return false;
+			}
+
+			print_batch_kernel(bch);
+		}
+
+		if (ping.enable)
+		{
+			if (!open_shared(pgh, L"ping", HEADER))
+			{
+				return false;
+			}
+
+			print_ping(pgh);
+		}
+
+		if (trace.enable)
+		{
+			if (!open_shared(tch, L"trace", HEADER))
+			{
+				return false;
+			}
+
+			print_trace(tch);
+		}
+
+		if (rate_limit.enable) // filled at close, once every [rate = n] message is known
+		{
+			if (!open_shared(rlh, L"rate", HEADER))
+			{
+				return false;
+			}
+		}
+
+		// the stream dispatcher is where received trailers get checked, so integrity brings it along
+		if (uring.enable || integrity.enable || ping.enable || bot.enable || loopback.enable)
+		{
+			if (!open_shared(stm, L"stream", HEADER))
+			{
+				return false;
+			}
+
+			print_stream(stm);
+		}
+
+		if (uring.enable)
+		{
+			if (!open_shared(urh, L"uring", HEADER))
+			{
+				return false;
+			}
+
+			print_uring(urh);
+		}
+
+		if (bot.enable)
+		{
+			if (!open_shared(bth, L"bot", CPP))
+			{
+				return false;
+			}
+		}
+
+		if (loopback.enable)
+		{
+			if (!open_shared(lbc, L"loopback", CPP))
+			{
+				return false;
+			}
+		}
+
+		for (int s_c = 0; s_c < 2; ++s_c)
+		{
+			if (s_c == SERVER && !creation.server_side)
+			{
+				continue;
+			}
+
+			if (s_c == CLIENT && !creation.client_side)
+			{
+				continue;
+			}
+
+			for (int s_p = 0; s_p < 2; ++s_p)
+			{
+				FileInfo* head = file_info[s_c][s_p][HEADER];
+				FileInfo* cpp = file_info[s_c][s_p][CPP];
+
+				head->s_c = s_c;
+				cpp->s_c = s_c;
+
+				head->s_p = s_p;
+				cpp->s_p = s_p;
+
+				head->h_c = HEADER;
+				cpp->h_c = CPP;
+
+				head->filename[0] = L'\0';
+				cpp->filename[0] = L'\0';
+
+				if (creation.global_prefix)
+				{
+					wcscat_s(head->filename, FILENAME_MAX, ns.global);
+					wcscat_s(head->filename, FILENAME_MAX, L"_");
+					wcscat_s(cpp->filename, FILENAME_MAX, ns.global);
+					wcscat_s(cpp->filename, FILENAME_MAX, L"_");
+				}
+
+				if (creation.side_prefix)
+				{
+					wcscat_s(head->filename, FILENAME_MAX, RPC_SIDE[s_c]);
+					wcscat_s(head->filename, FILENAME_MAX, L"_");
+					wcscat_s(cpp->filename, FILENAME_MAX, RPC_SIDE[s_c]);
+					wcscat_s(cpp->filename, FILENAME_MAX, L"_");
+				}
+
+				wcscat_s(head->filename, FILENAME_MAX, RPC_PART[s_p]);
+				wcscat_s(cpp->filename, FILENAME_MAX, RPC_PART[s_p]);
+
+				wcscat_s(head->filename, FILENAME_MAX, EXTENSION[HEADER]);
+				wcscat_s(cpp->filename, FILENAME_MAX, EXTENSION[CPP]);
+
+				if (_wfopen_s(&head->file, head->filename, L"wt, ccs=UNICODE") != 0 ||
+					head->file == nullptr)
+				{
+					return false;
+				}
+
+				if (_wfopen_s(&cpp->file, cpp->filename, L"wt, ccs=UNICODE") != 0 ||
+					cpp->file == nullptr)
+				{
+					return false;
+				}
+
+				print_header(*head, *cpp, s_c, s_p);
+
+				if (ns.enable || ns.enable_side)
+				{
+					print_namespace(*head, *cpp, s_c);
+				}
+
+				print_class(*head, s_p);
+
+				if (s_p == STUB)
+				{
+					print_dispatch_stub(*head);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void parse()
+	{
+		FILE* file = nullptr;
+		if (_wfopen_s(&file, L"rpc/protocol.txt", L"rt, ccs=UNICODE") != 0 || file == nullptr)
+		{
+			wprintf(L"failed to open ./rpc/protocol.txt\n");
+			return;
+		}
+
+		wchar_t line[FILENAME_MAX];
+		while (fgetws(line, FILENAME_MAX, file))
+		{
+			if (!parse_line(line))
+			{
+				break;
+			}
+		}
+
+		print_close();
+
+		fclose(file);
+	}
+
+	bool parse_line(const wchar_t* line)
+	{
+		int pos = skip(line, L" \t\r\n");
+		if (pos == -1)
+		{
+			return true;
+		}
+
+		if (wcsncmp(line + pos, L"TYPE", 4) == 0)
+		{
+			return parse_protocol_type(line + pos + 4);
+		}
+		else
+		{
+			return parse_protocol(line + pos);
+		}
+
+		return false;
+	}
+
+	bool parse_protocol_type(const wchar_t* line)
+	{
+		int pos = skip(line, L" \t=");
+		if (pos == -1)
+		{
+			return false;
+		}
+
+		int len = until(line + pos, L" \t\r\n");
+		if (len == 0)
+		{
+			return false;
+		}
+
+		protocol.protocol_type = _wtoi(line + pos);
+
+		return true;
+	}
+
+	bool parse_protocol(const wchar_t* line)
+	{
+		int pos = skip(line, L" \t");
+		if (pos == -1)
+		{
+			return false;
+		}
+
+		int len = until(line + pos, L"(");
+		if (len == 0)
+		{
+			return false;
+		}
+
+		int copy_len = min(len, BUFFER_SIZE - 1);
+		wcsncpy_s(protocol.name, BUFFER_SIZE, line + pos, copy_len);
+		protocol.name[copy_len] = L'\0';
+
+		for (int i = 0; i <= copy_len; ++i)
+		{
+			protocol.lower_name[i] = towlower(protocol.name[i]);
+		}
+
+		// CS_MOVE_START -> CsMoveStart
+		int class_len = 0;
+		for (int i = 0; i < copy_len; ++i)
+		{
+			if (protocol.name[i] == L'_')
+			{
+				continue;
+			}
+
+			bool word_start = i == 0 || protocol.name[i - 1] == L'_';
+			protocol.class_name[class_len++] = word_start ? towupper(protocol.name[i]) : towlower(protocol.name[i]);
+		}
+		protocol.class_name[class_len] = L'\0';
+
+		pos = pos + len + 1; // (  Ŵ
+
+		int end_pos = pos + until(line + pos, L")");
+
+		while (pos < end_pos && protocol.param_cnt < MAX_PARAMETER_CNT)
+		{
+			while (line[pos] == L' ' || line[pos] == L'\t')
+			{
+				++pos;
+			}
+
+			len = until(line + pos, L",)");
+
+			while (line[pos + len - 1] == L' ' || line[pos + len - 1] == L'\t')
+			{
+				--len;
+			}
+
+			// pos = Ȯ Ÿ  ε, len = Ÿ + ̸ 
+
+			int name_len = 1;
+			while (line[pos + len - name_len] != L' ')
+			{
+				++name_len;
+			}
+
+			// name_len  ̽ٸ  
+
+			int type_len = len - name_len;
+
+			wcsncpy_s(protocol.param_type[protocol.param_cnt], BUFFER_SIZE, line + pos, type_len);
+
+			pos = pos + type_len + 1;
+
+			wcsncpy_s(protocol.param_name[protocol.param_cnt], BUFFER_SIZE, line + pos, name_len - 1);
+
+			len = until(line + pos, L",)");
+
+			pos = pos + len + 1;
+
+			++protocol.param_cnt;
+		}
+
+		if (!parse_attribute(line + end_pos + 1) || !set_coalesce() || !set_rate())
+		{
+			return false;
+		}
+
+		protocol.min_size = 0;
+
+		int string_size = 0;
+
+		for (int i = 0; i < protocol.param_cnt; ++i)
+		{
+			protocol.param_length[i] = 0;
+
+			if (wcsncmp(protocol.param_type[i], L"string<", 7) == 0 || wcsncmp(protocol.param_type[i], L"wstring<", 8) == 0)
+			{
+				if (!set_string(i))
+				{
+					return false;
+				}
+
+				// a length byte, then up to N characters
+				protocol.min_size += 1;
+				string_size += protocol.param_length[i] * protocol.param_size[i];
+
+				continue;
+			}
+
+			if (type_map.enable && !map_type(i))
+			{
+				return false;
+			}
+
+			protocol.param_size[i] = wire_size(protocol.param_type[i]);
+
+			if (protocol.param_size[i] == -1)
+			{
+				if (decode.enable || gather.enable || traits.enable || is_batch_encoded(protocol)) // fields laid out at fixed offsets
+				{
+					wprintf(L"unknown parameter type: %s(%s %s)\n",
+						protocol.name, protocol.param_type[i], protocol.param_name[i]);
+					return false;
+				}
+
+				continue;
+			}
+
+			protocol.min_size += protocol.param_size[i];
+		}
+
+		protocol.max_size = protocol.min_size + string_size;
+
+		if (string_size > 0 && !check_string())
+		{
+			return false;
+		}
+
+		// batch frames sit at fixed strides
+		if (is_batch_encoded(protocol) && is_packed(protocol))
+		{
+			wprintf(L"a [batch] message cannot be packed: %s\n", protocol.name);
+			return false;
+		}
+
+		// a column is named after its parameter plus s, next to the sessions column
+		for (int i = 0; is_batched(protocol) && i < protocol.param_cnt; ++i)
+		{
+			if (wcscmp(protocol.param_name[i], L"session") == 0)
+			{
+				wprintf(L"a [batch] parameter named session would collide with the sessions column: %s\n", protocol.name);
+				return false;
+			}
+		}
+
+		if (protocol.protocol_type > type_id.max)
+		{
+			wprintf(L"protocol type out of range: %s = %d\n", protocol.name, protocol.protocol_type);
+			return false;
+		}
+
+		if (protocol_cnt == MAX_PROTOCOL_CNT)
+		{
+			wprintf(L"too many protocols: %s\n", protocol.name);
+			return false;
+		}
+
+		if (ping.enable && (protocol.protocol_type == ping.request_type || protocol.protocol_type == ping.reply_type))
+		{
+			wprintf(L"protocol type taken by ping: %s = %d\n", protocol.name, protocol.protocol_type);
+			return false;
+		}
+
+		if (layout.enable)
+		{
+			set_traffic();
+		}
+
+		print_protocol();
+
+		protocols[protocol_cnt++] = protocol;
+
+		++protocol.protocol_type;
+
+		protocol.param_cnt = 0;
+
+		return true;
+	}
+
+	bool parse_attribute(const wchar_t* line)
+	{
+		protocol.priority = PRIORITY_NORMAL;
+		protocol.droppable = false;
+		protocol.compress = false;
+		protocol.batch = false;
+		protocol.weight = 1;
+		protocol.rate = 0;
+		protocol.burst = 0;
+		protocol.coalesce_by[0] = L'\0';
+		protocol.coalesce_group[0] = L'\0';
+
+		int pos = skip(line, L" \t");
+		if (pos == -1 || line[pos] != L'[')
+		{
+			return true;
+		}
+
+		++pos;
+
+		int end_pos = pos + until(line + pos, L"]");
+		if (line[end_pos] != L']')
+		{
+			wprintf(L"unclosed attribute: %s\n", protocol.name);
+			return false;
+		}
+
+		while (pos < end_pos)
+		{
+			wchar_t key[BUFFER_SIZE] = L"";
+			wchar_t value[BUFFER_SIZE] = L"";
+
+			pos += skip(line + pos, L" \t");
+
+			int len = until(line + pos, L" \t=,]");
+			wcsncpy_s(key, BUFFER_SIZE, line + pos, min(len, BUFFER_SIZE - 1));
+
+			pos += len;
+			pos += skip(line + pos, L" \t");
+
+			if (line[pos] == L'=')
+			{
+				++pos;
+				pos += skip(line + pos, L" \t");
+
+				len = until(line + pos, L" \t,]");
+				wcsncpy_s(value, BUFFER_SIZE, line + pos, min(len, BUFFER_SIZE - 1));
+
+				pos += len;
+				pos += skip(line + pos, L" \t");
+			}
+
+			if (!set_attribute(key, value))
+			{
+				return false;
+			}
+
+			if (line[pos] == L',')
+			{
+				++pos;
+			}
+		}
+
+		return true;
+	}
+
+	bool set_attribute(const wchar_t* key, const wchar_t* value)
+	{
+		if (wcscmp(key, L"priority") == 0)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				if (_wcsicmp(value, PRIORITY_NAME[i]) == 0)
+				{
+					protocol.priority = i;
+					return true;
+				}
+			}
+		}
+		else if (wcscmp(key, L"droppable") == 0)
+		{
+			if (value[0] == L'\0' || wcscmp(value, L"true") == 0)
+			{
+				protocol.droppable = true;
+				return true;
+			}
+
+			if (wcscmp(value, L"false") == 0)
+			{
+				protocol.droppable = false;
+				return true;
+			}
+		}
+		else if (wcscmp(key, L"compress") == 0 && value[0] == L'\0')
+		{
+			protocol.compress = true;
+			return true;
+		}
+		else if (wcscmp(key, L"batch") == 0 && value[0] == L'\0')
+		{
+			protocol.batch = true;
+			return true;
+		}
+		else if (wcscmp(key, L"weight") == 0 && value[0] != L'\0' && wcsspn(value, L"0123456789") == wcslen(value))
+		{
+			protocol.weight = _wtoi(value);
+			return true;
+		}
+		else if ((wcscmp(key, L"rate") == 0 || wcscmp(key, L"burst") == 0)
+			&& value[0] != L'\0' && wcslen(value) <= 6 && wcsspn(value, L"0123456789") == wcslen(value) && _wtoi(value) > 0)
+		{
+			(key[0] == L'r' ? protocol.rate : protocol.burst) = _wtoi(value);
+			return true;
+		}
+		else if (wcscmp(key, L"coalesce_by") == 0 && value[0] != L'\0')
+		{
+			wcscpy_s(protocol.coalesce_by, BUFFER_SIZE, value);
+			return true;
+		}
+		else if (wcscmp(key, L"coalesce_group") == 0 && value[0] != L'\0')
+		{
+			wcscpy_s(protocol.coalesce_group, BUFFER_SIZE, value);
+			return true;
+		}
+
+		wprintf(L"wrong attribute: %s [%s = %s]\n", protocol.name, key, value);
+		return false;
+	}
+
+	bool set_coalesce()
+	{
+		protocol.coalesce_param = -1;
+		protocol.group_id = 0;
+
+		if (protocol.coalesce_by[0] == L'\0')
+		{
+			if (protocol.coalesce_group[0] != L'\0')
+			{
+				wprintf(L"coalesce_group without coalesce_by: %s\n", protocol.name);
+				return false;
+			}
+
+			return true;
+		}
+
+		for (int i = 0; i < protocol.param_cnt; ++i)
+		{
+			if (wcscmp(protocol.param_name[i], protocol.coalesce_by) == 0)
+			{
+				protocol.coalesce_param = i;
+				break;
+			}
+		}
+
+		if (protocol.coalesce_param == -1)
+		{
+			wprintf(L"coalesce_by is not a parameter: %s(%s)\n", protocol.name, protocol.coalesce_by);
+			return false;
+		}
+
+		if (protocol.coalesce_group[0] == L'\0')
+		{
+			wcscpy_s(protocol.coalesce_group, BUFFER_SIZE, protocol.name);
+		}
+
+		// frames of one group replace each other in place, so they must queue alike
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			if (wcscmp(protocols[i].coalesce_group, protocol.coalesce_group) != 0)
+			{
+				continue;
+			}
+
+			if (protocols[i].priority != protocol.priority || protocols[i].droppable != protocol.droppable)
+			{
+				wprintf(L"coalesce group %s mixes priority or droppable: %s, %s\n",
+					protocol.coalesce_group, protocols[i].name, protocol.name);
+				return false;
+			}
+
+			protocol.group_id = protocols[i].group_id;
+			return true;
+		}
+
+		protocol.group_id = ++group_cnt;
+
+		return true;
+	}
+
+	bool set_rate()
+	{
+		protocol.rate_slot = -1;
+
+		if (protocol.rate == 0)
+		{
+			if (protocol.burst != 0)
+			{
+				wprintf(L"burst without rate: %s\n", protocol.name);
+				return false;
+			}
+
+			return true;
+		}
+
+		if (protocol.burst == 0)
+		{
+			protocol.burst = protocol.rate;
+		}
+
+		protocol.rate_slot = rate_slot_cnt++;
+
+		return true;
+	}
+
+	// true when the message opens a new shape whose bodies have to be printed first
+	bool set_shape()
+	{
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			if (is_same_shape(protocols[i], protocol))
+			{
+				protocol.shape_id = protocols[i].shape_id;
+				return false;
+			}
+		}
+
+		protocol.shape_id = ++shape_cnt;
+
+		return true;
+	}
+
+	// the mapped headers skip Windows.h, so its typedefs have to be mapped away
+	// string<N> -> std::string_view, wstring<N> -> std::u16string_view, N characters at most
+	bool set_string(int param)
+	{
+		wchar_t* type = protocol.param_type[param];
+		bool wide = type[0] == L'w';
+
+		const wchar_t* number = type + (wide ? 8 : 7);
+		int len = until(number, L">");
+
+		protocol.param_length[param] = _wtoi(number);
+		protocol.param_size[param] = wide ? 2 : 1;
+
+		if (len == 0 || static_cast<int>(wcsspn(number, L"0123456789")) != len || number[len] != L'>' || number[len + 1] != L'\0'
+			|| protocol.param_length[param] < 1 || protocol.param_length[param] > 255)
+		{
+			wprintf(L"bad string parameter: %s(%s %s)\n", protocol.name, type, protocol.param_name[param]);
+			return false;
+		}
+
+		wcscpy_s(type, BUFFER_SIZE, wide ? L"std::u16string_view" : L"std::string_view");
+
+		return true;
+	}
+
+	// handlers get views into the receive buffer, so only plain decoded calls may take them
+	bool check_string()
+	{
+		if (protocol.max_size > 255)
+		{
+			wprintf(L"payload can exceed 255 bytes: %s\n", protocol.name);
+			return false;
+		}
+
+		if (!decode.enable)
+		{
+			wprintf(L"string parameters need dispatch.decode: %s\n", protocol.name);
+			return false;
+		}
+
+		if (view.enable || traits.enable || is_batched(protocol) || is_batch_encoded(protocol))
+		{
+			wprintf(L"string parameters have no fixed offsets for dispatch.view, traits or [batch]: %s\n", protocol.name);
+			return false;
+		}
+
+		if (coroutine.enable)
+		{
+			wprintf(L"string parameters would outlive the receive buffer in a suspended handler: %s\n", protocol.name);
+			return false;
+		}
+
+		if (protocol.coalesce_param != -1 && protocol.param_length[protocol.coalesce_param] > 0)
+		{
+			wprintf(L"coalesce_by must name a scalar parameter: %s\n", protocol.name);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool map_type(int param)
+	{
+		wchar_t* type = protocol.param_type[param];
+
+		for (int i = 0; i < type_map.cnt; ++i)
+		{
+			if (wcscmp(type_map.from[i], type) == 0)
+			{
+				wcscpy_s(type, BUFFER_SIZE, type_map.to[i]);
+				return true;
+			}
+		}
+
+		static const wchar_t* const windows_types[] =
+		{
+			L"BYTE", L"WORD", L"DWORD", L"INT", L"UINT", L"INT64", L"UINT64", L"ULONGLONG", L"__int64",
+		};
+
+		for (const wchar_t* windows_type : windows_types)
+		{
+			if (wcscmp(windows_type, type) == 0)
+			{
+				wprintf(L"unmapped Windows type: %s(%s %s)\n", protocol.name, type, protocol.param_name[param]);
+				return false;
+			}
+		}
+
+		// wchar_t is 2 bytes only on Windows, the portable build has to say char16_t
+		if (wcscmp(type, L"wchar_t") == 0)
+		{
+			wprintf(L"wchar_t is 4 bytes off Windows, map it to char16_t: %s(%s %s)\n", protocol.name, type, protocol.param_name[param]);
+			return false;
+		}
+
+		return true;
+	}
+
+	void set_traffic()
+	{
+		protocol.traffic = 0;
+
+		for (int i = 0; i < profile_cnt; ++i)
+		{
+			bool by_type = iswdigit(profile[i].name[0]) && _wtoi(profile[i].name) == protocol.protocol_type;
+
+			if (by_type || wcscmp(profile[i].name, protocol.name) == 0)
+			{
+				protocol.traffic += profile[i].count;
+				profile[i].used = true;
+			}
+		}
+	}
+
+	// hottest types up to layout.hot percent of the side's traffic, cold ones under layout.cold parts per million
+	void set_tier(int s_c)
+	{
+		double total = 0;
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			if (is_stub_of(protocols[i], s_c))
+			{
+				protocols[i].tier = TIER_WARM;
+				total += protocols[i].traffic;
+			}
+		}
+
+		hot_case_cnt = 0;
+		cold_case_cnt = 0;
+
+		if (total == 0) // nothing profiled for this side, the plain switch stays
+		{
+			return;
+		}
+
+		double covered = 0;
+
+		while (hot_case_cnt < MAX_HOT_CASE && covered * 100 < total * layout.hot)
+		{
+			int hottest = -1;
+
+			for (int i = 0; i < protocol_cnt; ++i)
+			{
+				if (is_stub_of(protocols[i], s_c) && protocols[i].tier == TIER_WARM && protocols[i].traffic > 0 &&
+					(hottest == -1 || protocols[i].traffic > protocols[hottest].traffic))
+				{
+					hottest = i;
+				}
+			}
+
+			if (hottest == -1)
+			{
+				break;
+			}
+
+			protocols[hottest].tier = TIER_HOT;
+			hot_case[hot_case_cnt++] = hottest;
+			covered += protocols[hottest].traffic;
+		}
+
+		hot_likely = hot_case_cnt > 0 && protocols[hot_case[0]].traffic * 2 > total;
+
+		// a page lookup costs the same for every 16-bit type, so they all stay in the tables
+		for (int i = 0; i < protocol_cnt && type_id.bits != 16; ++i)
+		{
+			if (is_stub_of(protocols[i], s_c) && protocols[i].tier == TIER_WARM &&
+				protocols[i].traffic * 1000000 < total * layout.cold)
+			{
+				protocols[i].tier = TIER_COLD;
+				++cold_case_cnt;
+			}
+		}
+	}
+
+	int wire_size(const wchar_t* type)
+	{
+		static const struct
+		{
+			const wchar_t* type;
+			int size;
+		} sizes[] =
+		{
+			{ L"bool", 1 }, { L"char", 1 }, { L"signed char", 1 }, { L"unsigned char", 1 }, { L"BYTE", 1 },
+			{ L"int8_t", 1 }, { L"uint8_t", 1 },
+			{ L"short", 2 }, { L"unsigned short", 2 }, { L"wchar_t", 2 }, { L"WORD", 2 },
+			{ L"int16_t", 2 }, { L"uint16_t", 2 }, { L"char16_t", 2 },
+			{ L"int", 4 }, { L"unsigned int", 4 }, { L"float", 4 },
+			{ L"DWORD", 4 }, { L"INT", 4 }, { L"UINT", 4 }, { L"int32_t", 4 }, { L"uint32_t", 4 },
+			{ L"long long", 8 }, { L"unsigned long long", 8 }, { L"double", 8 }, { L"__int64", 8 },
+			{ L"INT64", 8 }, { L"UINT64", 8 }, { L"ULONGLONG", 8 }, { L"int64_t", 8 }, { L"uint64_t", 8 },
+		};
+
+		for (const auto& entry : sizes)
+		{
+			if (wcscmp(entry.type, type) == 0)
+			{
+				return entry.size;
+			}
+		}
+
+		return -1;
+	}
+
+	int until(const wchar_t* line, const wchar_t* token)
+	{
+		int token_cnt = static_cast<int>(wcslen(token));
+		int len = 0;
+
+		while (line[len])
+		{
+			bool matched = false;
+
+			for (int i = 0; i < token_cnt; ++i)
+			{
+				if (line[len] == token[i])
+				{
+					matched = true;
+					break;
+				}
+			}
+
+			if (matched)
+			{
+				break;
+			}
+
+			++len;
+		}
+
+		return len;
+	}
+
+	int skip(const wchar_t* line, const wchar_t* token)
+	{
+		int token_cnt = static_cast<int>(wcslen(token));
+		int len = 0;
+
+		while (line[len])
+		{
+			bool matched = false;
+
+			for (int i = 0; i < token_cnt; ++i)
+			{
+				if (line[len] == token[i])
+				{
+					matched = true;
+					++len;
+					break;
+				}
+			}
+
+			if (!matched)
+			{
+				break;
+			}
+		}
+
+		return line[len] == L'\0' ? -1 : len;
+	}
+
+	void print_header(FileInfo& header, FileInfo& cpp, int s_c, int s_p)
+	{
+		// pointers are all a header needs, unless the proxy bodies live there too
+		bool declare = type_map.forward_declare && !(s_p == PROXY && proxy.inline_body);
+
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(cpp.file, L"#include \"%s\"\n\n", header.filename);
+
+		long header_start = ftell(header.file);
+
+		if (s_p == STUB)
+		{
+			wchar_t session_header[FILENAME_MAX] = L"";
+
+			if (ns.enable || session.global_prefix)
+			{
+				wcscat_s(session_header, FILENAME_MAX, ns.global);
+				wcscat_s(session_header, FILENAME_MAX, L"_");
+			}
+
+			if (session.side_prefix)
+			{
+				wcscat_s(session_header, FILENAME_MAX, RPC_SIDE[s_c]);
+				wcscat_s(session_header, FILENAME_MAX, L"_");
+			}
+
+			wcscat_s(session_header, FILENAME_MAX, session.header);
+
+			if (!declare)
+			{
+				fwprintf(header.file, L"#include \"%s\"\n\n", session_header);
+			}
+
+			fwprintf(cpp.file, L"#include \"%s\"\n\n", session_header);
+
+			if (logger.enable)
+			{
+				fwprintf(cpp.file, L"#include \"%s\"\n", logger.header);
+			}
+
+			if (profiler.enable)
+			{
+				fwprintf(cpp.file, L"#include \"%s\"\n", profiler.header);
+			}
+		}
+
+		if (!declare)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n", serial_buffer.header);
+		}
+
+		fwprintf(cpp.file, L"#include \"%s\"\n", serial_buffer.header);
+
+		if (s_p == PROXY && outbox.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n", obh.filename);
+		}
+
+		if (s_p == PROXY && gather.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n", gth.filename);
+		}
+
+		if (s_p == PROXY && send_queue.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n", sqh.filename);
+		}
+
+		if (s_p == PROXY && batch_encode.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n", bch.filename);
+		}
+
+		if (s_p == PROXY && integrity.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n", igh.filename);
+		}
+
+		if (compress.enable)
+		{
+			fwprintf((s_p == PROXY ? header : cpp).file, L"#include \"%s\"\n", czh.filename);
+		}
+
+		if (s_p == STUB && coroutine.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n", tkh.filename);
+		}
+
+		if (s_p == STUB && view.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n", vwh.filename);
+		}
+
+		if (s_p == STUB && rate_limit.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n", rlh.filename);
+		}
+
+		if (trace.enable)
+		{
+			fwprintf((s_p == PROXY && proxy.inline_body ? header : cpp).file, L"#include \"%s\"\n", tch.filename);
+		}
+
+		// a forward-declared header may have nothing after #pragma once yet, whose blank line already separates
+		const wchar_t* gap = ftell(header.file) == header_start ? L"" : L"\n";
+
+		if (type_map.enable)
+		{
+			fwprintf(header.file, L"%s#include <cstdint>\n", gap);
+			fwprintf(cpp.file, L"\n#include <cstdint>\n");
+		}
+		else if (s_p == PROXY || decode.enable) // decoded handlers take the parameter types directly
+		{
+			fwprintf(header.file, L"%s#define WIN32_LEAN_AND_MEAN\n#include <Windows.h>\n", gap);
+			fwprintf(cpp.file, L"\n#define WIN32_LEAN_AND_MEAN\n#include <Windows.h>\n");
+		}
+
+		// decoded dispatch checks sizes up front and never catches
+		if (try_catch.enable && !decode.enable)
+		{
+			fwprintf(cpp.file, L"\n#include <stdexcept>\n");
+		}
+
+		if (s_p == STUB && decode.enable)
+		{
+			fwprintf(cpp.file, L"\n#include <cstring>\n");
+		}
+
+		if (s_p == PROXY && (uring.enable || batch_encode.enable))
+		{
+			fwprintf(header.file, L"\n#include <cstddef>\n#include <span>\n");
+		}
+
+		if (s_p == STUB && batch.enable)
+		{
+			fwprintf(header.file, L"\n#include <span>\n");
+		}
+
+		// string<N> and wstring<N> parameters travel as views wherever check_string lets them, a proxy sends what the other stub handles
+		if (decode.enable && !view.enable && !traits.enable && !coroutine.enable && string_stub[s_p == STUB ? s_c : 1 - s_c])
+		{
+			fwprintf(header.file, L"\n#include <string_view>\n");
+		}
+
+		if (s_p == PROXY && (uring.enable || gather.enable || send_queue.enable))
+		{
+			fwprintf(proxy.inline_body ? header.file : cpp.file, L"\n#include <cstring>\n");
+		}
+
+		// batch encoders stay out of line even with proxy.inline, their plans live in the cpp
+		if (s_p == PROXY && batch_encode.enable && (proxy.inline_body || !(uring.enable || gather.enable || send_queue.enable)))
+		{
+			fwprintf(cpp.file, L"\n#include <cstring>\n");
+		}
+
+		// a shared body inlined back into every wrapper would be copied again
+		if (s_p == PROXY && proxy.shared)
+		{
+			fwprintf(cpp.file, L"\n#if defined(_MSC_VER)\n#define RPC_NOINLINE __declspec(noinline)\n#else\n#define RPC_NOINLINE __attribute__((noinline))\n#endif\n");
+		}
+
+		// logs and rare types go to .text.unlikely, away from the hot dispatch path
+		if (s_p == STUB && layout.enable)
+		{
+			fwprintf(cpp.file, L"\n#if defined(_MSC_VER)\n#define RPC_COLD __declspec(noinline)\n#else\n#define RPC_COLD __attribute__((noinline, cold))\n#endif\n");
+		}
+
+		if (declare)
+		{
+			fwprintf(header.file, L"%s", ftell(header.file) == header_start ? L"" : L"\n");
+			fwprintf(header.file, L"class %s;\n", serial_buffer.type);
+		}
+
+		fwprintf(header.file, L"\n");
+		fwprintf(cpp.file, L"\n");
+	}
+
+	void print_namespace(FileInfo& header, FileInfo& cpp, int s_c)
+	{
+		if (ns.enable)
+		{
+			fwprintf(header.file, L"namespace %s\n", ns.global);
+			fwprintf(cpp.file, L"namespace %s\n", ns.global);
+
+			fwprintf(header.file, L"{\n");
+			fwprintf(cpp.file, L"{\n");
+
+			++header.tab_cnt;
+			++cpp.tab_cnt;
+
+			if (ns.enable_side)
+			{
+				print_tab(header);
+				fwprintf(header.file, L"namespace %s\n", RPC_SIDE[s_c]);
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"namespace %s\n", RPC_SIDE[s_c]);
+
+				print_tab(header);
+				fwprintf(header.file, L"{\n");
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"{\n");
+
+				++header.tab_cnt;
+				++cpp.tab_cnt;
+			}
+		}
+		else if (ns.enable_side)
+		{
+			fwprintf(header.file, L"namespace %s\n", RPC_SIDE[s_c]);
+			fwprintf(cpp.file, L"namespace %s\n", RPC_SIDE[s_c]);
+
+			fwprintf(header.file, L"{\n");
+			fwprintf(cpp.file, L"{\n");
+
+			++header.tab_cnt;
+			++cpp.tab_cnt;
+		}
+	}
+
+	void print_class(FileInfo& header, int s_p)
+	{
+		// the stub names its session unqualified, so the declaration joins it in the stub's namespace
+		if (s_p == STUB && type_map.forward_declare)
+		{
+			print_tab(header);
+			fwprintf(header.file, L"class %s;\n\n", session.type);
+		}
+
+		if (s_p == STUB && rate_limit.enable)
+		{
+			print_tab(header);
+			fwprintf(header.file, L"// defined next to the session that owns it, dispatch spends from it before decoding\n");
+
+			print_tab(header);
+			fwprintf(header.file, L"RateLimiter& rate_limit(%s* %s);\n\n", session.type, session.param);
+		}
+
+		print_tab(header);
+		if (s_p == STUB && coroutine.enable)
+		{
+			fwprintf(header.file, L"class %s : public Scheduler\n", RPC_CLASS[s_p]);
+		}
+		else
+		{
+			fwprintf(header.file, L"class %s\n", RPC_CLASS[s_p]);
+		}
+
+		print_tab(header);
+		fwprintf(header.file, L"{\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"public:\n");
+
+		++header.tab_cnt;
+
+		if (s_p == STUB)
+		{
+			print_tab(header);
+			fwprintf(header.file, L"virtual ~%s() {}\n\n", RPC_CLASS[s_p]);
+
+			if (coroutine.enable)
+			{
+				if (!decode.enable || view.enable)
+				{
+					print_tab(header);
+					fwprintf(header.file, L"// handlers read the message before their first co_await, dispatch reuses the buffer\n");
+				}
+
+				print_tab(header);
+				fwprintf(header.file, L"// result of a handler that suspended, reported once resume_scheduled() has run it to the end\n");
+
+				print_tab(header);
+				fwprintf(header.file, L"virtual void complete(%s*, bool) {}\n\n", session.type);
+			}
+		}
+	}
+
+	void print_dispatch_stub(FileInfo& header)
+	{
+		print_tab(header);
+		fwprintf(header.file, L"bool dispatch(%s* %s, %s type, %s* %s);\n",
+			session.type, session.param, type_id.name, serial_buffer.type, serial_buffer.param);
+
+		if (decode.enable)
+		{
+			print_tab(header);
+			fwprintf(header.file, L"bool dispatch(%s* %s, %s type, const char* payload, int size);\n",
+				session.type, session.param, type_id.name);
+		}
+
+		if (compress.enable)
+		{
+			print_tab(header);
+			fwprintf(header.file, L"bool dispatch_compressed(%s* %s, %s type, const char* payload, int size);\n",
+				session.type, session.param, type_id.name);
+		}
+
+		fwprintf(header.file, L"\n");
+	}
+
+	void print_dispatch_body(FileInfo& cpp)
+	{
+		if (layout.enable)
+		{
+			set_tier(cpp.s_c);
+		}
+
+		if (type_id.bits == 16 || decode.enable || is_rated(cpp.s_c) || has_cold_path())
+		{
+			print_dispatch_table(cpp);
+		}
+
+		if (decode.enable)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"bool %s::dispatch(%s* %s, %s type, %s* %s)\n",
+				RPC_CLASS[STUB], session.type, session.param, type_id.name, serial_buffer.type, serial_buffer.param);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn dispatch(%s, type, reinterpret_cast<const char*>(%s->read_pos()), %s->size());\n",
+				session.param, serial_buffer.param, serial_buffer.param);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"bool %s::dispatch(%s* %s, %s type, const char* payload, int size)\n",
+				RPC_CLASS[STUB], session.type, session.param, type_id.name);
+		}
+		else
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"bool %s::dispatch(%s* %s, %s type, %s* %s)\n",
+				RPC_CLASS[STUB], session.type, session.param, type_id.name, serial_buffer.type, serial_buffer.param);
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		if (trace.enable)
+		{
+			print_tab(cpp);
+			if (decode.enable)
+			{
+				fwprintf(cpp.file, L"%s_TRACE_DISPATCH(type, size, %s);\n\n", trace.prefix, session.param);
+			}
+			else
+			{
+				fwprintf(cpp.file, L"%s_TRACE_DISPATCH(type, %s->size(), %s);\n\n", trace.prefix, serial_buffer.param, session.param);
+			}
+		}
+
+		if (profiler.enable)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"%s\n\n", profiler.expression);
+		}
+
+		if (is_rated(cpp.s_c))
+		{
+			print_dispatch_rate(cpp);
+		}
+
+		// decoded handlers never read through the buffer, so there is nothing to catch
+		bool use_try_catch = try_catch.enable && !decode.enable;
+
+		if (use_try_catch)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"try\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			++cpp.tab_cnt;
+		}
+
+		if (decode.enable)
+		{
+			print_dispatch_bound(cpp);
+		}
+
+		if (type_id.bits == 16)
+		{
+			print_dispatch_lookup(cpp);
+		}
+		else
+		{
+			print_dispatch_switch(cpp);
+		}
+
+		if (use_try_catch)
+		{
+			--cpp.tab_cnt;
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n"); // try
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"catch (const %s& e)\n", try_catch.type);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			++cpp.tab_cnt;
+
+			if (layout.enable && logger.enable && dispatch.enable_exception)
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"return on_exception(type, e);\n");
+			}
+			else
+			{
+				if (logger.enable && dispatch.enable_exception)
+				{
+					print_tab(cpp);
+					fwprintf(cpp.file, L"%s\n", dispatch.exception);
+				}
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"return false;\n");
+			}
+
+			--cpp.tab_cnt;
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n"); // catch
+		}
+
+		--cpp.tab_cnt;
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n"); // dispatch
+
+		if (compress.enable)
+		{
+			print_dispatch_compressed(cpp);
+		}
+	}
+
+	void print_dispatch_compressed(FileInfo& cpp)
+	{
+		fwprintf(cpp.file, L"\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"bool %s::dispatch_compressed(%s* %s, %s type, const char* payload, int size)\n",
+			RPC_CLASS[STUB], session.type, session.param, type_id.name);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		// handlers read the unpacked payload in place, so it lives as long as a receive buffer would
+		print_tab(cpp);
+		fwprintf(cpp.file, L"thread_local char unpacked[255];\n\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"int unpacked_size = decompress_payload(payload, size, unpacked, sizeof(unpacked));\n\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"if (unpacked_size < 0)\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"\treturn false;\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"return dispatch(%s, type, unpacked, unpacked_size);\n", session.param);
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n");
+	}
+
+	void print_dispatch_bound(FileInfo& cpp)
+	{
+		print_tab(cpp);
+		if (type_id.bits == 16)
+		{
+			fwprintf(cpp.file, L"const PayloadSize& bound = PAYLOAD_SIZE[PAGE[type >> 8]][type & 0xFF];\n\n");
+		}
+		else
+		{
+			fwprintf(cpp.file, L"const PayloadSize& bound = PAYLOAD_SIZE[type];\n\n");
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"if (size < bound.min_size || size > bound.max_size)\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		// unknown types carry the empty bound { 0xFFFF, 0 } and never reach the lookup or switch
+		if (logger.enable && dispatch.enable_weird_type)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"if (bound.min_size > bound.max_size)\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			if (layout.enable)
+			{
+				fwprintf(cpp.file, L"\treturn on_weird_type(type);\n");
+			}
+			else
+			{
+				fwprintf(cpp.file, L"\t%s\n", dispatch.weird_type);
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"\treturn false;\n");
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+		}
+
+		if (layout.enable && logger.enable && dispatch.enable_bad_size)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"return on_bad_size(type, size);\n");
+		}
+		else
+		{
+			if (logger.enable && dispatch.enable_bad_size)
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"%s\n", dispatch.bad_size);
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"return false;\n");
+		}
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n\n");
+	}
+
+	void print_dispatch_rate(FileInfo& cpp)
+	{
+		print_tab(cpp);
+		if (type_id.bits == 16)
+		{
+			fwprintf(cpp.file, L"const int slot = RATE_SLOT[PAGE[type >> 8]][type & 0xFF];\n\n");
+		}
+		else
+		{
+			fwprintf(cpp.file, L"const int slot = RATE_SLOT[type];\n\n");
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"if (slot != NO_RATE_SLOT && !rate_limit(%s).admit(slot, rate_tick_ms()))\n", session.param);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, rate_limit.disconnect ? L"\treturn false;\n" : L"\treturn true; // dropped, counted in RateLimiter::rejected()\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n\n");
+	}
+
+	void print_dispatch_hot(FileInfo& cpp)
+	{
+		if (hot_case_cnt == 0)
+		{
+			return;
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"// hottest first, as profiled in %s\n", layout.profile);
+
+		for (int i = 0; i < hot_case_cnt; ++i)
+		{
+			const Protocol& info = protocols[hot_case[i]];
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"if (type == %d)%s\n", info.protocol_type, i == 0 && hot_likely ? L" [[likely]]" : L"");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t");
+			print_dispatch_call(cpp, info, true);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+		}
+	}
+
+	void print_dispatch_switch(FileInfo& cpp)
+	{
+		int case_cnt = 0;
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			if (is_stub_of(protocols[i], cpp.s_c) && (!layout.enable || protocols[i].tier == TIER_WARM))
+			{
+				++case_cnt;
+			}
+		}
+
+		if (layout.enable)
+		{
+			print_dispatch_hot(cpp);
+
+			if (case_cnt == 0)
+			{
+				print_dispatch_miss(cpp);
+				return;
+			}
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"switch (type)\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			if (!is_stub_of(protocols[i], cpp.s_c) || (layout.enable && protocols[i].tier != TIER_WARM))
+			{
+				continue;
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"case %d:\n", protocols[i].protocol_type);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t");
+			print_dispatch_call(cpp, protocols[i], true);
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"default:\n");
+
+		++cpp.tab_cnt;
+		print_dispatch_miss(cpp);
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n"); // switch
+	}
+
+	void print_dispatch_call(FileInfo& cpp, const Protocol& info, bool member)
+	{
+		if (decode.enable)
+		{
+			fwprintf(cpp.file, L"return decode_%s(%s, %s, payload%s);\n",
+				info.lower_name, member ? L"this" : L"stub", session.param, is_sized(cpp.s_c) ? L", size" : L"");
+		}
+		else
+		{
+			fwprintf(cpp.file, L"return %s%s(%s, %s)%s;\n", member ? L"" : L"stub->",
+				info.lower_name, session.param, serial_buffer.param, coroutine.enable ? L".run()" : L"");
+		}
+	}
+
+	// an unknown type, or one of the cold types when the profile left some
+	void print_dispatch_miss(FileInfo& cpp)
+	{
+		if (layout.enable && cold_case_cnt > 0)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"return dispatch_cold(this, %s, type, %s%s);\n",
+				session.param, decode.enable ? L"payload" : serial_buffer.param, is_sized(cpp.s_c) ? L", size" : L"");
+			return;
+		}
+
+		// decoded dispatch logged unknown types at the bound check already
+		if (decode.enable)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"return false;\n");
+			return;
+		}
+
+		if (layout.enable && logger.enable && dispatch.enable_weird_type)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"return on_weird_type(type);\n");
+			return;
+		}
+
+		if (logger.enable && dispatch.enable_weird_type)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"%s\n", dispatch.weird_type);
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"return false;\n");
+	}
+
+	// error logs and rarely seen types, kept out of the hot text of dispatch
+	void print_dispatch_cold(FileInfo& cpp)
+	{
+		int printed = 0;
+
+		if (logger.enable && dispatch.enable_weird_type)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"RPC_COLD bool on_weird_type(%s%s)\n", type_id.name, is_used(dispatch.weird_type, L"type") ? L" type" : L"");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t%s\n", dispatch.weird_type);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn false;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+
+			++printed;
+		}
+
+		if (logger.enable && dispatch.enable_bad_size && decode.enable)
+		{
+			if (printed++ > 0)
+			{
+				fwprintf(cpp.file, L"\n");
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"RPC_COLD bool on_bad_size(%s%s, int%s)\n", type_id.name,
+				is_used(dispatch.bad_size, L"type") ? L" type" : L"", is_used(dispatch.bad_size, L"size") ? L" size" : L"");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t%s\n", dispatch.bad_size);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn false;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		if (logger.enable && dispatch.enable_exception && try_catch.enable && !decode.enable)
+		{
+			if (printed++ > 0)
+			{
+				fwprintf(cpp.file, L"\n");
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"RPC_COLD bool on_exception(%s%s, const %s&%s)\n", type_id.name,
+				is_used(dispatch.exception, L"type") ? L" type" : L"", try_catch.type, is_used(dispatch.exception, L"e") ? L" e" : L"");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t%s\n", dispatch.exception);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn false;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		if (cold_case_cnt == 0)
+		{
+			return;
+		}
+
+		if (printed > 0)
+		{
+			fwprintf(cpp.file, L"\n");
+		}
+
+		print_tab(cpp);
+		if (decode.enable)
+		{
+			fwprintf(cpp.file, L"RPC_COLD bool dispatch_cold(%s* stub, %s* %s, %s type, const char* payload%s)\n",
+				RPC_CLASS[STUB], session.type, session.param, type_id.name, is_sized(cpp.s_c) ? L", int size" : L"");
+		}
+		else
+		{
+			fwprintf(cpp.file, L"RPC_COLD bool dispatch_cold(%s* stub, %s* %s, %s type, %s* %s)\n",
+				RPC_CLASS[STUB], session.type, session.param, type_id.name, serial_buffer.type, serial_buffer.param);
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"switch (type)\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			if (!is_stub_of(protocols[i], cpp.s_c) || protocols[i].tier != TIER_COLD)
+			{
+				continue;
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"case %d:\n", protocols[i].protocol_type);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t");
+			print_dispatch_call(cpp, protocols[i], false);
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"default:\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, logger.enable && dispatch.enable_weird_type && !decode.enable ? L"\treturn on_weird_type(type);\n" : L"\treturn false;\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n"); // switch
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n");
+	}
+
+	void print_dispatch_lookup(FileInfo& cpp)
+	{
+		const wchar_t* entry = decode.enable ? L"Decoder" : L"Handler";
+		const wchar_t* table = decode.enable ? L"DECODER" : L"HANDLER";
+
+		if (layout.enable)
+		{
+			print_dispatch_hot(cpp);
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"%s handler = %s[PAGE[type >> 8]][type & 0xFF];\n\n", entry, table);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"if (handler == nullptr)\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+		print_dispatch_miss(cpp);
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n\n");
+
+		print_tab(cpp);
+		if (decode.enable)
+		{
+			fwprintf(cpp.file, L"return handler(this, %s, payload%s);\n", session.param, is_sized(cpp.s_c) ? L", size" : L"");
+		}
+		else
+		{
+			fwprintf(cpp.file, L"return (this->*handler)(%s, %s)%s;\n",
+				session.param, serial_buffer.param, coroutine.enable ? L".run()" : L"");
+		}
+	}
+
+	void print_dispatch_table(FileInfo& cpp)
+	{
+		// high byte -> page, page 0 stays empty so unknown types hit nullptr
+		int page[256] = {};
+		int page_hi[257] = {};
+		int page_cnt = 1;
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			if (!is_stub_of(protocols[i], cpp.s_c))
+			{
+				continue;
+			}
+
+			int hi = protocols[i].protocol_type >> 8;
+			if (page[hi] == 0)
+			{
+				page_hi[page_cnt] = hi;
+				page[hi] = page_cnt++;
+			}
+		}
+
+		if (is_batch_side(cpp.s_c))
+		{
+			print_batch_queue(cpp);
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"namespace\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		if (decode.enable)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"struct PayloadSize\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tunsigned short min_size;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tunsigned short max_size;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"};\n\n");
+
+			for (int i = 0; i < protocol_cnt; ++i)
+			{
+				if (is_stub_of(protocols[i], cpp.s_c))
+				{
+					print_decoder(cpp, protocols[i]);
+				}
+			}
+		}
+
+		// a byte per type keeps the lookup in a few cache lines, wider only past 255 limited messages
+		const wchar_t* slot_type = rate_slot_cnt < 0xFF ? L"unsigned char" : L"unsigned short";
+
+		if (is_rated(cpp.s_c))
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"constexpr int NO_RATE_SLOT = %s;\n\n", rate_slot_cnt < 0xFF ? L"0xFF" : L"0xFFFF");
+		}
+
+		if (type_id.bits == 16)
+		{
+			print_tab(cpp);
+			if (decode.enable)
+			{
+				fwprintf(cpp.file, L"using Decoder = bool (*)(%s*, %s*, const char*%s);\n\n",
+					RPC_CLASS[STUB], session.type, is_sized(cpp.s_c) ? L", int" : L"");
+			}
+			else
+			{
+				fwprintf(cpp.file, L"using Handler = %s (%s::*)(%s*, %s*);\n\n",
+					coroutine.enable ? L"Task" : L"bool", RPC_CLASS[STUB], session.type, serial_buffer.type);
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"constexpr unsigned short PAGE[256] =\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			for (int hi = 0; hi < 256; hi += 16)
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"\t");
+
+				for (int i = hi; i < hi + 16; ++i)
+				{
+					fwprintf(cpp.file, i == hi + 15 ? L"%d,\n" : L"%d, ", page[i]);
+				}
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"};\n\n");
+
+			if (decode.enable)
+			{
+				print_dispatch_pages(cpp, L"Decoder DECODER", page_hi, page_cnt, ENTRY_DECODER);
+				fwprintf(cpp.file, L"\n");
+				print_dispatch_pages(cpp, L"PayloadSize PAYLOAD_SIZE", page_hi, page_cnt, ENTRY_SIZE);
+			}
+			else
+			{
+				print_dispatch_pages(cpp, L"Handler HANDLER", page_hi, page_cnt, ENTRY_HANDLER);
+			}
+
+			if (is_rated(cpp.s_c))
+			{
+				fwprintf(cpp.file, L"\n");
+				print_dispatch_pages(cpp, rate_slot_cnt < 0xFF ? L"unsigned char RATE_SLOT" : L"unsigned short RATE_SLOT",
+					page_hi, page_cnt, ENTRY_RATE);
+			}
+		}
+		else
+		{
+			if (decode.enable)
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"constexpr PayloadSize PAYLOAD_SIZE[256] =\n");
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"{\n");
+
+				print_dispatch_page(cpp, 0, ENTRY_SIZE);
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"};\n");
+			}
+
+			if (is_rated(cpp.s_c))
+			{
+				if (decode.enable)
+				{
+					fwprintf(cpp.file, L"\n");
+				}
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"constexpr %s RATE_SLOT[256] =\n", slot_type);
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"{\n");
+
+				print_dispatch_page(cpp, 0, ENTRY_RATE);
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"};\n");
+			}
+		}
+
+		if (has_cold_path())
+		{
+			if (type_id.bits == 16 || decode.enable || is_rated(cpp.s_c))
+			{
+				fwprintf(cpp.file, L"\n");
+			}
+
+			print_dispatch_cold(cpp);
+		}
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n\n");
+	}
+
+	void print_dispatch_pages(FileInfo& cpp, const wchar_t* declaration, const int* page_hi, int page_cnt, int kind)
+	{
+		print_tab(cpp);
+		fwprintf(cpp.file, L"constexpr %s[%d][256] =\n", declaration, page_cnt);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{},\n");
+
+		for (int pg = 1; pg < page_cnt; ++pg)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{ // 0x%02Xnn\n", page_hi[pg]);
+
+			print_dispatch_page(cpp, page_hi[pg], kind);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"},\n");
+		}
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"};\n");
+	}
+
+	void print_dispatch_page(FileInfo& cpp, int hi, int kind)
+	{
+		for (int lo = 0; lo < 256; ++lo)
+		{
+			const Protocol* found = nullptr;
+
+			for (int i = 0; i < protocol_cnt; ++i)
+			{
+				if (is_stub_of(protocols[i], cpp.s_c) && protocols[i].protocol_type == ((hi << 8) | lo))
+				{
+					found = &protocols[i];
+					break;
+				}
+			}
+
+			if (lo % 8 == 0)
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"\t");
+			}
+
+			if (kind == ENTRY_RATE)
+			{
+				if (found && found->rate_slot != -1)
+				{
+					fwprintf(cpp.file, L"%d,", found->rate_slot);
+				}
+				else
+				{
+					fwprintf(cpp.file, rate_slot_cnt < 0xFF ? L"0xFF," : L"0xFFFF,");
+				}
+			}
+			else if (kind == ENTRY_SIZE)
+			{
+				if (found)
+				{
+					fwprintf(cpp.file, L"{ %d, %d },", found->min_size, found->max_size);
+				}
+				else
+				{
+					fwprintf(cpp.file, L"{ 0xFFFF, 0 },");
+				}
+			}
+			else if (found)
+			{
+				if (kind == ENTRY_DECODER)
+				{
+					fwprintf(cpp.file, L"&decode_%s,", found->lower_name);
+				}
+				else
+				{
+					fwprintf(cpp.file, L"&%s::%s,", RPC_CLASS[STUB], found->lower_name);
+				}
+			}
+			else
+			{
+				fwprintf(cpp.file, L"nullptr,");
+			}
+
+			fwprintf(cpp.file, lo % 8 == 7 ? L"\n" : L" ");
+		}
+	}
+
+	// flush_batch() for every stub, so tick code compiles on either side, and the columns of this side's [batch] messages
+	void print_batch_stub(FileInfo& header)
+	{
+		fwprintf(header.file, L"\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"// [batch] frames wait in columns until this call, in arrival order within a type and type order across types\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"void flush_batch();\n");
+
+		if (!is_batch_side(header.s_c))
+		{
+			return;
+		}
+
+		fwprintf(header.file, L"\n");
+
+		--header.tab_cnt;
+		print_tab(header);
+		fwprintf(header.file, L"private:\n");
+		++header.tab_cnt;
+
+		print_tab(header);
+		fwprintf(header.file, L"friend struct BatchQueue; // dispatch appends [batch] frames to the columns through it\n\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"static constexpr int BATCH_CAPACITY = %d;\n\n", batch.capacity);
+
+		// a column per parameter, aligned so batch handlers can load whole vectors
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			const Protocol& info = protocols[i];
+
+			if (!is_stub_of(info, header.s_c) || !is_batched(info))
+			{
+				continue;
+			}
+
+			print_tab(header);
+			fwprintf(header.file, L"struct %sColumns\n", info.class_name);
+
+			print_tab(header);
+			fwprintf(header.file, L"{\n");
+
+			print_tab(header);
+			fwprintf(header.file, L"\talignas(64) %s* sessions[BATCH_CAPACITY];\n", session.type);
+
+			for (int j = 0; j < info.param_cnt; ++j)
+			{
+				print_tab(header);
+				fwprintf(header.file, L"\talignas(64) %s %ss[BATCH_CAPACITY];\n", info.param_type[j], info.param_name[j]);
+			}
+
+			print_tab(header);
+			fwprintf(header.file, L"\tint cnt = 0;\n");
+
+			print_tab(header);
+			fwprintf(header.file, L"};\n\n");
+		}
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			const Protocol& info = protocols[i];
+
+			if (is_stub_of(info, header.s_c) && is_batched(info))
+			{
+				print_tab(header);
+				fwprintf(header.file, L"%sColumns %s_columns_;\n", info.class_name, info.lower_name);
+			}
+		}
+	}
+
+	// the friend of a stub with [batch] messages, its decoders append to the private columns through it
+	void print_batch_queue(FileInfo& cpp)
+	{
+		print_tab(cpp);
+		fwprintf(cpp.file, L"struct BatchQueue\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		int queued_cnt = 0;
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			const Protocol& info = protocols[i];
+
+			if (!is_stub_of(info, cpp.s_c) || !is_batched(info))
+			{
+				continue;
+			}
+
+			if (queued_cnt++ > 0)
+			{
+				fwprintf(cpp.file, L"\n");
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"static bool %s(%s* stub, %s* %s%s)\n",
+				info.lower_name, RPC_CLASS[STUB], session.type, session.param, info.param_cnt > 0 ? L", const char* payload" : L"");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			++cpp.tab_cnt;
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"if (stub->%s_columns_.cnt == %s::BATCH_CAPACITY)\n", info.lower_name, RPC_CLASS[STUB]);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tstub->flush_batch();\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"int n = stub->%s_columns_.cnt++;\n\n", info.lower_name);
+
+			// dispatch checked the size, each field lands in its column at a fixed payload offset
+			print_tab(cpp);
+			fwprintf(cpp.file, L"stub->%s_columns_.sessions[n] = %s;\n", info.lower_name, session.param);
+
+			int offset = 0;
+
+			for (int j = 0; j < info.param_cnt; ++j)
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"memcpy(&stub->%s_columns_.%ss[n], payload + %d, %d);\n",
+					info.lower_name, info.param_name[j], offset, info.param_size[j]);
+
+				offset += info.param_size[j];
+			}
+
+			fwprintf(cpp.file, L"\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"return true;\n");
+
+			--cpp.tab_cnt;
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"};\n\n");
+	}
+
+	void print_batch_body(FileInfo& cpp)
+	{
+		fwprintf(cpp.file, L"\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"void %s::flush_batch()\n", RPC_CLASS[STUB]);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		int batched_cnt = 0;
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			const Protocol& info = protocols[i];
+
+			if (!is_stub_of(info, cpp.s_c) || !is_batched(info))
+			{
+				continue;
+			}
+
+			if (batched_cnt++ > 0)
+			{
+				fwprintf(cpp.file, L"\n");
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"if (%s_columns_.cnt > 0)\n", info.lower_name);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t%s_batch(std::span<%s* const>(%s_columns_.sessions, %s_columns_.cnt)",
+				info.lower_name, session.type, info.lower_name, info.lower_name);
+
+			for (int j = 0; j < info.param_cnt; ++j)
+			{
+				fwprintf(cpp.file, L", %s_columns_.%ss", info.lower_name, info.param_name[j]);
+			}
+
+			fwprintf(cpp.file, L");\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t%s_columns_.cnt = 0;\n", info.lower_name);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n");
+	}
+
+	void print_decoder(FileInfo& cpp, const Protocol& info)
+	{
+		// only string messages read the size, the other decoders leave it unnamed
+		const wchar_t* size_param = !is_sized(cpp.s_c) ? L"" : has_string(info) ? L", int size" : L", int";
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"bool decode_%s(%s* stub, %s* %s, const char*%s%s)\n",
+			info.lower_name, RPC_CLASS[STUB], session.type, session.param, info.param_cnt > 0 || view.enable ? L" payload" : L"", size_param);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		if (is_batched(info)) // waits in the stub's columns for flush_batch()
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"return BatchQueue::%s(stub, %s%s);\n",
+				info.lower_name, session.param, info.param_cnt > 0 ? L", payload" : L"");
+
+			--cpp.tab_cnt;
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+
+			return;
+		}
+
+		if (view.enable) // bounds were checked by dispatch, the handler reads only what it touches
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"return stub->%s(%s, %sView(payload))%s;\n",
+				info.lower_name, session.param, info.class_name, coroutine.enable ? L".run()" : L"");
+
+			--cpp.tab_cnt;
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+
+			return;
+		}
+
+		if (has_string(info))
+		{
+			print_string_decode(cpp, info);
+		}
+		else
+		{
+			for (int i = 0; i < info.param_cnt; ++i)
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"%s %s;\n", info.param_type[i], info.param_name[i]);
+			}
+
+			int offset = 0;
+
+			for (int i = 0; i < info.param_cnt; ++i)
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"memcpy(&%s, payload + %d, %d);\n", info.param_name[i], offset, info.param_size[i]);
+
+				offset += info.param_size[i];
+			}
+
+			if (info.param_cnt > 0)
+			{
+				fwprintf(cpp.file, L"\n");
+			}
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"return stub->%s(%s", info.lower_name, session.param);
+
+		for (int i = 0; i < info.param_cnt; ++i)
+		{
+			fwprintf(cpp.file, L", %s", info.param_name[i]);
+		}
+
+		fwprintf(cpp.file, L")%s;\n", coroutine.enable ? L".run()" : L"");
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n\n");
+	}
+
+	// strings become views into the payload or, for wstring<N>, into a per-thread copy, each length is checked against its N and what the size leaves for it
+	void print_string_decode(FileInfo& cpp, const Protocol& info)
+	{
+		int last_string = -1;
+
+		for (int i = 0; i < info.param_cnt; ++i)
+		{
+			if (info.param_length[i] > 0)
+			{
+				last_string = i;
+			}
+		}
+
+		// bytes every field from param on needs at least: scalars, and a length byte per string
+		int rest[MAX_PARAMETER_CNT + 1] = {};
+
+		for (int i = info.param_cnt - 1; i >= 0; --i)
+		{
+			rest[i] = rest[i + 1] + (info.param_length[i] > 0 ? 1 : info.param_size[i]);
+		}
+
+		int offset = 0;
+		wchar_t term[BUFFER_SIZE] = L""; // characters of the strings so far
+
+		for (int i = 0; i < info.param_cnt; ++i)
+		{
+			if (info.param_length[i] == 0)
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"%s %s;\n", info.param_type[i], info.param_name[i]);
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"memcpy(&%s, payload + %d%s, %d);\n\n", info.param_name[i], offset, term, info.param_size[i]);
+
+				offset += info.param_size[i];
+
+				continue;
+			}
+
+			const wchar_t* name = info.param_name[i];
+			bool wide = info.param_size[i] == 2;
+
+			// the bound check or the previous string left this length byte inside the payload
+			print_tab(cpp);
+			fwprintf(cpp.file, L"unsigned char %s_len = static_cast<unsigned char>(payload[%d%s]);\n\n", name, offset, term);
+
+			wchar_t start[BUFFER_SIZE];
+			wcscpy_s(start, BUFFER_SIZE, term);
+
+			wcscat_s(term, BUFFER_SIZE, L" + ");
+			wcscat_s(term, BUFFER_SIZE, name);
+			wcscat_s(term, BUFFER_SIZE, wide ? L"_len * 2" : L"_len");
+
+			// the last string has to end the payload exactly
+			print_tab(cpp);
+			fwprintf(cpp.file, L"if (%s_len > %d || size %s %d%s)\n", name, info.param_length[i], i == last_string ? L"!=" : L"<", offset + rest[i], term);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn false;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+
+			// UTF-16 units may start at an odd offset, so they are copied out before char16_t reads them
+			if (wide)
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"thread_local char16_t %s_units[%d];\n", name, info.param_length[i]);
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"memcpy(%s_units, payload + %d%s, %s_len * 2);\n", name, offset + 1, start, name);
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"%s %s(%s_units, %s_len);\n\n", info.param_type[i], name, name, name);
+			}
+			else
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"%s %s(payload + %d%s, %s_len);\n\n", info.param_type[i], name, offset + 1, start, name);
+			}
+
+			offset += 1;
+		}
+	}
+
+	void print_protocol()
+	{
+		if (protocol.name[0] == L'S') // server proxy, client stub 
+		{
+			if (creation.server_side)
+			{
+				print_protocol_proxy(sph, spc);
+			}
+
+			if (creation.client_side)
+			{
+				print_protocol_stub(csh);
+			}
+		}
+		else // L'C' -> server stub, client proxy 
+		{
+			if (creation.server_side)
+			{
+				print_protocol_stub(ssh);
+			}
+
+			if (creation.client_side)
+			{
+				print_protocol_proxy(cph, cpc);
+			}
+		}
+	}
+
+	void print_protocol_stub(FileInfo& header)
+	{
+		// coroutine handlers finish inline or suspend, dispatch only sees Task::run()
+		const wchar_t* result = coroutine.enable ? L"Task" : L"bool";
+
+		print_tab(header);
+
+		if (is_batched(protocol))
+		{
+			// one call per flush with every frame of this type as columns, a session rejects itself
+			fwprintf(header.file, L"virtual void %s_batch(std::span<%s* const> sessions", protocol.lower_name, session.type);
+
+			for (int i = 0; i < protocol.param_cnt; ++i)
+			{
+				fwprintf(header.file, L", const %s* %ss", protocol.param_type[i], protocol.param_name[i]);
+			}
+
+			fwprintf(header.file, L") = 0;\n");
+		}
+		else if (view.enable)
+		{
+			fwprintf(header.file, L"virtual %s %s(%s* %s, %sView view) = 0;\n",
+				result, protocol.lower_name, session.type, session.param, protocol.class_name);
+		}
+		else if (decode.enable)
+		{
+			fwprintf(header.file, L"virtual %s %s(%s* %s", result, protocol.lower_name, session.type, session.param);
+
+			for (int i = 0; i < protocol.param_cnt; ++i)
+			{
+				fwprintf(header.file, L", %s %s", protocol.param_type[i], protocol.param_name[i]);
+			}
+
+			fwprintf(header.file, L") = 0;\n");
+		}
+		else
+		{
+			fwprintf(header.file, L"virtual %s %s(%s* %s, %s* %s) = 0;\n",
+				result, protocol.lower_name, session.type, session.param, serial_buffer.type, serial_buffer.param);
+		}
+	}
+
+	void print_protocol_proxy(FileInfo& header, FileInfo& cpp)
+	{
+		// the first message of a wire shape brings the bodies its later siblings call
+		if (proxy.shared && set_shape())
+		{
+			print_shape(cpp);
+		}
+
+		// with the outbox every encoder hands back how its frame may be queued, the drain seals it in send order
+		const wchar_t* result = outbox.enable ? L"FrameTag" : L"void";
+
+		defer_seal = outbox.enable;
+
+		// inline encoders are defined in the class body, the cpp keeps only its includes
+		FileInfo& body = proxy.inline_body ? header : cpp;
+
+		wchar_t buffer_type[BUFFER_SIZE];
+		wcscpy_s(buffer_type, BUFFER_SIZE, serial_buffer.type);
+		wcscat_s(buffer_type, BUFFER_SIZE, L"*");
+
+		print_proxy_signature(header, body, result, buffer_type, serial_buffer.param);
+
+		print_tab(body);
+		fwprintf(body.file, L"{\n");
+
+		++body.tab_cnt;
+
+		if (proxy.shared)
+		{
+			print_shape_call(body, L"", serial_buffer.param);
+		}
+		else
+		{
+			print_buffer_body(body);
+		}
+
+		if (outbox.enable)
+		{
+			if (proxy.shared || is_packed(protocol) || integrity.enable || trace.enable)
+			{
+				fwprintf(body.file, L"\n");
+			}
+
+			print_tab(body);
+			if (protocol.group_id != 0)
+			{
+				fwprintf(body.file, L"return FrameTag{ Priority::%s, %s, %d, static_cast<unsigned long long>(%s) };\n",
+					PRIORITY_NAME[protocol.priority], protocol.droppable ? L"true" : L"false",
+					protocol.group_id, protocol.param_name[protocol.coalesce_param]);
+			}
+			else
+			{
+				fwprintf(body.file, L"return FrameTag{ Priority::%s, %s, 0, 0 };\n",
+					PRIORITY_NAME[protocol.priority], protocol.droppable ? L"true" : L"false");
+			}
+		}
+
+		--body.tab_cnt;
+
+		print_tab(body);
+		fwprintf(body.file, L"}\n\n");
+
+		defer_seal = false;
+
+		if (uring.enable)
+		{
+			print_protocol_span(header, cpp);
+		}
+
+		if (gather.enable)
+		{
+			print_protocol_gather(header, cpp);
+		}
+
+		if (send_queue.enable)
+		{
+			print_protocol_send(header, cpp);
+		}
+
+		if (is_batch_encoded(protocol))
+		{
+			print_protocol_batch(header, cpp);
+		}
+	}
+
+	void print_buffer_body(FileInfo& body)
+	{
+		print_string_length(body, false);
+
+		if (type_id.bits == 16)
+		{
+			// code, size and type go out as one little-endian store
+			print_tab(body);
+			fwprintf(body.file, L"unsigned int header = %s | (", CODE_VALUE);
+			print_type_term(body);
+			fwprintf(body.file, L" << 16);\n");
+
+			print_tab(body);
+			fwprintf(body.file, L"%s->clear();\n", serial_buffer.param);
+
+			print_tab(body);
+			fwprintf(body.file, L"*%s << header << ", serial_buffer.param);
+		}
+		else
+		{
+			print_tab(body);
+			fwprintf(body.file, L"unsigned char code = %s;\n", CODE_VALUE);
+
+			print_tab(body);
+			fwprintf(body.file, L"unsigned char size = 0;\n");
+
+			if (!shape_body)
+			{
+				print_tab(body);
+				fwprintf(body.file, L"unsigned char type = %d;\n", protocol.protocol_type);
+			}
+
+			print_tab(body);
+			fwprintf(body.file, L"%s->clear();\n", serial_buffer.param);
+
+			print_tab(body);
+			fwprintf(body.file, L"*%s << code << size << type << ", serial_buffer.param);
+		}
+
+		for (int i = 0; i < protocol.param_cnt; ++i)
+		{
+			if (protocol.param_length[i] == 0)
+			{
+				fwprintf(body.file, L"%s", protocol.param_name[i]);
+
+				if (i != protocol.param_cnt - 1)
+				{
+					fwprintf(body.file, L" << ");
+				}
+
+				continue;
+			}
+
+			// the length goes down the chain, the characters in one copy, an empty view may have no data() to copy from
+			fwprintf(body.file, L"%s_len;\n\n", protocol.param_name[i]);
+
+			print_tab(body);
+			fwprintf(body.file, L"if (%s_len > 0)\n", protocol.param_name[i]);
+
+			print_tab(body);
+			fwprintf(body.file, L"{\n");
+
+			print_tab(body);
+			if (protocol.param_size[i] == 2)
+			{
+				fwprintf(body.file, L"\t%s->%s(reinterpret_cast<const char*>(%s.data()), %s_len * 2);\n",
+					serial_buffer.param, serial_buffer.put_data, protocol.param_name[i], protocol.param_name[i]);
+			}
+			else
+			{
+				fwprintf(body.file, L"\t%s->%s(%s.data(), %s_len);\n",
+					serial_buffer.param, serial_buffer.put_data, protocol.param_name[i], protocol.param_name[i]);
+			}
+
+			print_tab(body);
+			fwprintf(body.file, L"}\n");
+
+			if (i != protocol.param_cnt - 1)
+			{
+				fwprintf(body.file, L"\n");
+
+				print_tab(body);
+				fwprintf(body.file, L"*%s << ", serial_buffer.param);
+			}
+		}
+
+		if (protocol.param_cnt == 0 || protocol.param_length[protocol.param_cnt - 1] == 0)
+		{
+			fwprintf(body.file, L";\n");
+		}
+
+		print_tab(body);
+		fwprintf(body.file, L"reinterpret_cast<unsigned char*>(%s->read_pos())[1] = static_cast<unsigned char>(%s->size() - %d);\n",
+			serial_buffer.param, serial_buffer.param, type_id.header_size);
+
+		if (is_packed(protocol))
+		{
+			print_packed_buffer(body);
+		}
+
+		// the trailer is reserved even without a guard so a later seal() can fill it, e.g. when the outbox drains
+		if (integrity.enable)
+		{
+			fwprintf(body.file, L"\n");
+
+			print_tab(body);
+			fwprintf(body.file, L"unsigned int trailer = 0;\n");
+
+			print_tab(body);
+			fwprintf(body.file, L"*%s << trailer;\n", serial_buffer.param);
+		}
+
+		if (integrity.enable && !defer_seal)
+		{
+			fwprintf(body.file, L"\n");
+
+			print_tab(body);
+			fwprintf(body.file, L"if (guard != nullptr)\n");
+
+			print_tab(body);
+			fwprintf(body.file, L"{\n");
+
+			print_tab(body);
+			fwprintf(body.file, L"\tguard->seal(reinterpret_cast<char*>(%s->read_pos()), %s->size() - %d);\n",
+				serial_buffer.param, serial_buffer.param, TRAILER_SIZE);
+
+			print_tab(body);
+			fwprintf(body.file, L"}\n");
+		}
+
+		if (trace.enable)
+		{
+			wchar_t buffer_size[BUFFER_SIZE];
+			wcscpy_s(buffer_size, BUFFER_SIZE, serial_buffer.param);
+			wcscat_s(buffer_size, BUFFER_SIZE, L"->size()");
+
+			fwprintf(body.file, L"\n");
+			print_trace_encode(body, serial_buffer.param, buffer_size, 0);
+		}
+	}
+
+	void print_protocol_span(FileInfo& header, FileInfo& cpp)
+	{
+		// encodes straight into caller memory such as a registered send buffer, 0 when out is too small
+		FileInfo& body = proxy.inline_body ? header : cpp;
+
+		print_proxy_signature(header, body, L"size_t", L"std::span<std::byte>", L"out");
+
+		print_tab(body);
+		fwprintf(body.file, L"{\n");
+
+		++body.tab_cnt;
+
+		if (proxy.shared)
+		{
+			print_shape_call(body, L"return ", L"out");
+		}
+		else
+		{
+			print_span_body(body);
+		}
+
+		--body.tab_cnt;
+
+		print_tab(body);
+		fwprintf(body.file, L"}\n\n");
+	}
+
+	void print_span_body(FileInfo& body)
+	{
+		int payload_size = protocol.min_size;
+		int frame_size = type_id.header_size + payload_size + integrity.trailer_size;
+
+		// string lengths make payload_size a local of the encoder
+		bool sized = has_string(protocol);
+
+		wchar_t frame_end[BUFFER_SIZE];
+		swprintf(frame_end, BUFFER_SIZE, L"payload_size + %d", type_id.header_size);
+
+		print_string_length(body, true);
+
+		print_tab(body);
+		if (sized)
+		{
+			fwprintf(body.file, L"if (out.size() < static_cast<size_t>(payload_size) + %d)\n", type_id.header_size + integrity.trailer_size);
+		}
+		else
+		{
+			fwprintf(body.file, L"if (out.size() < %d)\n", frame_size);
+		}
+
+		print_tab(body);
+		fwprintf(body.file, L"{\n");
+
+		print_tab(body);
+		fwprintf(body.file, L"\treturn 0;\n");
+
+		print_tab(body);
+		fwprintf(body.file, L"}\n\n");
+
+		print_header_term(body);
+
+		print_tab(body);
+		fwprintf(body.file, L"std::byte* frame = out.data();\n\n");
+
+		print_frame_copy(body);
+
+		bool packed = is_packed(protocol);
+
+		if (packed)
+		{
+			fwprintf(body.file, L"\n");
+
+			print_tab(body);
+			if (sized)
+			{
+				fwprintf(body.file, L"int frame_size = compress_frame(reinterpret_cast<char*>(frame), payload_size);\n");
+			}
+			else
+			{
+				fwprintf(body.file, L"int frame_size = compress_frame(reinterpret_cast<char*>(frame), %d);\n", payload_size);
+			}
+		}
+
+		if (integrity.enable)
+		{
+			print_guard_seal(body, L"reinterpret_cast<char*>(frame)", packed ? L"frame_size" : sized ? frame_end : nullptr, type_id.header_size + payload_size);
+		}
+
+		if (trace.enable)
+		{
+			fwprintf(body.file, L"\n");
+
+			if (sized && !packed)
+			{
+				print_trace_encode(body, L"frame", L"payload_size", type_id.header_size + integrity.trailer_size);
+			}
+			else
+			{
+				print_trace_encode(body, L"frame", packed ? L"frame_size" : nullptr, packed ? integrity.trailer_size : frame_size);
+			}
+		}
+
+		fwprintf(body.file, L"\n");
+
+		print_tab(body);
+		if (packed && integrity.enable)
+		{
+			fwprintf(body.file, L"return frame_size + %d;\n", integrity.trailer_size);
+		}
+		else if (packed)
+		{
+			fwprintf(body.file, L"return frame_size;\n");
+		}
+		else if (sized)
+		{
+			fwprintf(body.file, L"return payload_size + %d;\n", type_id.header_size + integrity.trailer_size);
+		}
+		else
+		{
+			fwprintf(body.file, L"return %d;\n", frame_size);
+		}
+	}
+
+	void print_protocol_gather(FileInfo& header, FileInfo& cpp)
+	{
+		// the frame goes straight into the queue's chunk, no SerializeBuffer in between
+		FileInfo& body = proxy.inline_body ? header : cpp;
+
+		print_proxy_signature(header, body, L"void", L"GatherQueue&", L"out");
+
+		print_tab(body);
+		fwprintf(body.file, L"{\n");
+
+		++body.tab_cnt;
+
+		if (proxy.shared)
+		{
+			print_shape_call(body, L"", L"out");
+		}
+		else
+		{
+			print_gather_body(body);
+		}
+
+		--body.tab_cnt;
+
+		print_tab(body);
+		fwprintf(body.file, L"}\n\n");
+	}
+
+	void print_protocol_send(FileInfo& header, FileInfo& cpp)
+	{
+		// encoded into a frame of this thread's pool, published to the session with one exchange
+		FileInfo& body = proxy.inline_body ? header : cpp;
+
+		defer_seal = true;
+
+		print_proxy_signature(header, body, L"void", L"SendQueue&", L"queue");
+
+		print_tab(body);
+		fwprintf(body.file, L"{\n");
+
+		++body.tab_cnt;
+
+		print_tab(body);
+		fwprintf(body.file, L"SendFrame& out = SendPool::local().acquire();\n\n");
+
+		if (proxy.shared)
+		{
+			print_shape_call(body, L"", L"out");
+		}
+		else
+		{
+			print_gather_body(body);
+		}
+
+		fwprintf(body.file, L"\n");
+
+		print_tab(body);
+		fwprintf(body.file, L"queue.push(&out);\n");
+
+		--body.tab_cnt;
+
+		print_tab(body);
+		fwprintf(body.file, L"}\n\n");
+
+		defer_seal = false;
+	}
+
+	void print_protocol_batch(FileInfo& header, FileInfo& cpp)
+	{
+		// cnt frames back to back from columns, 16 at a time through the shuffle plan, 0 when out is too small
+		int frame_size = type_id.header_size + protocol.min_size + integrity.trailer_size;
+
+		print_batch_signature(header, false);
+
+		if (protocol.param_cnt > 0)
+		{
+			print_batch_plan(cpp, frame_size);
+		}
+
+		print_batch_signature(cpp, true);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"if (out.size() < cnt * %d)\n", frame_size);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"\treturn 0;\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"char* frames = reinterpret_cast<char*>(out.data());\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"size_t i = 0;\n\n");
+
+		if (protocol.param_cnt > 0)
+		{
+			fwprintf(cpp.file, L"#if defined(RPC_SHUFFLE)\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"for (; i + 16 <= cnt; i += 16)\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tconst char* columns[%d] = { ", protocol.param_cnt);
+
+			for (int i = 0; i < protocol.param_cnt; ++i)
+			{
+				fwprintf(cpp.file, i == 0 ? L"reinterpret_cast<const char*>(%ss + i)" : L", reinterpret_cast<const char*>(%ss + i)", protocol.param_name[i]);
+			}
+
+			fwprintf(cpp.file, L" };\n\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tshuffle_block(%s_PLAN, columns, frames + i * %d);\n", protocol.name, frame_size);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+
+			fwprintf(cpp.file, L"#endif\n\n");
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"unsigned int header = %s | (%du << 8) | (", CODE_VALUE, protocol.min_size);
+		print_type_term(cpp);
+		fwprintf(cpp.file, L" << 16);\n\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, protocol.param_cnt > 0 ? L"// the tail short of a block, or every frame without a shuffle kernel\n" : L"// a header is all there is to copy\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"for (; i < cnt; ++i)\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"char* frame = frames + i * %d;\n\n", frame_size);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"memcpy(frame, &header, %d);\n", type_id.header_size);
+
+		int offset = type_id.header_size;
+
+		for (int i = 0; i < protocol.param_cnt; ++i)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"memcpy(frame + %d, &%ss[i], %d);\n", offset, protocol.param_name[i], protocol.param_size[i]);
+
+			offset += protocol.param_size[i];
+		}
+
+		// a zero trailer, as the scalar encoders leave it for a later seal()
+		if (integrity.enable)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"memset(frame + %d, 0, %d);\n", offset, integrity.trailer_size);
+		}
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n");
+
+		if (integrity.enable || trace.enable)
+		{
+			fwprintf(cpp.file, L"\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"for (i = 0; i < cnt; ++i)\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			++cpp.tab_cnt;
+
+			if (integrity.enable)
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"char* frame = frames + i * %d;\n", frame_size);
+
+				print_guard_seal(cpp, L"frame", nullptr, frame_size - integrity.trailer_size);
+			}
+
+			if (trace.enable)
+			{
+				wchar_t frame[64];
+				swprintf(frame, 64, L"frames + i * %d", frame_size);
+
+				if (integrity.enable)
+				{
+					fwprintf(cpp.file, L"\n");
+				}
+
+				// without integrity a named frame would be unused once the tracepoints compile away
+				print_trace_encode(cpp, integrity.enable ? L"frame" : frame, nullptr, frame_size);
+			}
+
+			--cpp.tab_cnt;
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		fwprintf(cpp.file, L"\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"return cnt * %d;\n", frame_size);
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n\n");
+	}
+
+	void print_batch_signature(FileInfo& info, bool definition)
+	{
+		print_tab(info);
+		fwprintf(info.file, L"size_t %s%smp_%s_batch(std::span<std::byte> out",
+			definition ? RPC_CLASS[PROXY] : L"", definition ? L"::" : L"", protocol.lower_name);
+
+		if (integrity.enable)
+		{
+			fwprintf(info.file, L", FrameGuard* guard");
+		}
+
+		fwprintf(info.file, L", size_t cnt");
+
+		for (int i = 0; i < protocol.param_cnt; ++i)
+		{
+			fwprintf(info.file, L", const %s* %ss", protocol.param_type[i], protocol.param_name[i]);
+		}
+
+		fwprintf(info.file, definition ? L")\n" : L");\n");
+	}
+
+	// byte j of a 16-frame block comes from the header, a zero trailer or one byte of a column chunk,
+	// so each output chunk ORs its constant header bytes with one shuffle per column chunk it draws from
+	void print_batch_plan(FileInfo& cpp, int frame_size)
+	{
+		static unsigned char head[MAX_FRAME_SIZE][16];
+		static unsigned char step_source[MAX_FRAME_SIZE * 16];
+		static unsigned char step_mask[MAX_FRAME_SIZE * 16][16];
+		static int step_end[MAX_FRAME_SIZE];
+
+		int field_offset[MAX_PARAMETER_CNT];
+		int source_base[MAX_PARAMETER_CNT];
+		int source_cnt = 0;
+
+		for (int i = 0, offset = 0; i < protocol.param_cnt; ++i)
+		{
+			field_offset[i] = offset;
+			source_base[i] = source_cnt;
+
+			offset += protocol.param_size[i];
+			source_cnt += protocol.param_size[i]; // 16 elements of n bytes fill n chunks
+		}
+
+		unsigned int header_value = static_cast<unsigned int>(wcstoul(CODE_VALUE, nullptr, 16))
+			| (static_cast<unsigned int>(protocol.min_size) << 8) | (static_cast<unsigned int>(protocol.protocol_type) << 16);
+
+		int step_cnt = 0;
+
+		for (int j = 0; j < frame_size; ++j)
+		{
+			unsigned char mask[256][16];
+			bool used[256] = {};
+
+			for (int b = 0; b < 16; ++b)
+			{
+				int frame_byte = (16 * j + b) % frame_size;
+				int field_byte = frame_byte - type_id.header_size;
+
+				head[j][b] = frame_byte < type_id.header_size ? static_cast<unsigned char>(header_value >> (8 * frame_byte)) : 0;
+
+				if (field_byte < 0 || field_byte >= protocol.min_size)
+				{
+					continue;
+				}
+
+				int i = protocol.param_cnt - 1;
+				while (field_offset[i] > field_byte)
+				{
+					--i;
+				}
+
+				int element = (16 * j + b) / frame_size;
+				int source_byte = element * protocol.param_size[i] + field_byte - field_offset[i];
+				int source = source_base[i] + source_byte / 16;
+
+				if (!used[source])
+				{
+					used[source] = true;
+					memset(mask[source], 0x80, 16);
+				}
+
+				mask[source][b] = static_cast<unsigned char>(source_byte % 16);
+			}
+
+			for (int source = 0; source < source_cnt; ++source)
+			{
+				if (used[source])
+				{
+					step_source[step_cnt] = static_cast<unsigned char>(source);
+					memcpy(step_mask[step_cnt], mask[source], 16);
+					++step_cnt;
+				}
+			}
+
+			step_end[j] = step_cnt;
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"namespace\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"// 16 %s frames of %d bytes per block, %d output chunks from %d column chunks\n",
+			protocol.name, frame_size, frame_size, source_cnt);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"constexpr unsigned char %s_SOURCE[%d][2] =\n", protocol.name, source_cnt);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		for (int i = 0; i < protocol.param_cnt; ++i)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t");
+
+			for (int c = 0; c < protocol.param_size[i]; ++c)
+			{
+				fwprintf(cpp.file, c == 0 ? L"{ %d, %d }," : L" { %d, %d },", i, c);
+			}
+
+			fwprintf(cpp.file, L"\n");
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"};\n\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"constexpr unsigned char %s_HEAD[%d][16] =\n", protocol.name, frame_size);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		for (int j = 0; j < frame_size; ++j)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t{");
+
+			for (int b = 0; b < 16; ++b)
+			{
+				fwprintf(cpp.file, b == 0 ? L" 0x%02X" : L", 0x%02X", head[j][b]);
+			}
+
+			fwprintf(cpp.file, L" },\n");
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"};\n\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"constexpr unsigned short %s_STEP_END[%d] =\n", protocol.name, frame_size);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		for (int j = 0; j < frame_size; j += 16)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t");
+
+			for (int k = j; k < frame_size && k < j + 16; ++k)
+			{
+				fwprintf(cpp.file, k == j ? L"%d," : L" %d,", step_end[k]);
+			}
+
+			fwprintf(cpp.file, L"\n");
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"};\n\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"constexpr ShuffleStep %s_STEP[%d] =\n", protocol.name, step_cnt);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		for (int t = 0; t < step_cnt; ++t)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t{ %d, {", step_source[t]);
+
+			for (int b = 0; b < 16; ++b)
+			{
+				fwprintf(cpp.file, b == 0 ? L" 0x%02X" : L", 0x%02X", step_mask[t][b]);
+			}
+
+			fwprintf(cpp.file, L" } },\n");
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"};\n\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"constexpr ShufflePlan %s_PLAN = { %d, %d, %s_SOURCE, %s_HEAD, %s_STEP_END, %s_STEP };\n",
+			protocol.name, frame_size, source_cnt, protocol.name, protocol.name, protocol.name, protocol.name);
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n\n");
+	}
+
+	void print_gather_body(FileInfo& body)
+	{
+		bool sized = has_string(protocol);
+
+		wchar_t frame_end[BUFFER_SIZE];
+		swprintf(frame_end, BUFFER_SIZE, L"payload_size + %d", type_id.header_size);
+
+		print_string_length(body, true);
+
+		print_header_term(body);
+
+		print_tab(body);
+		if (sized)
+		{
+			fwprintf(body.file, L"char* frame = out.reserve(payload_size + %d);\n\n", type_id.header_size + integrity.trailer_size);
+		}
+		else
+		{
+			fwprintf(body.file, L"char* frame = out.reserve(%d);\n\n", type_id.header_size + protocol.min_size + integrity.trailer_size);
+		}
+
+		print_frame_copy(body);
+
+		bool packed = is_packed(protocol);
+
+		if (packed)
+		{
+			fwprintf(body.file, L"\n");
+
+			print_tab(body);
+			if (sized)
+			{
+				fwprintf(body.file, L"int frame_size = compress_frame(frame, payload_size);\n");
+
+				print_tab(body);
+				fwprintf(body.file, L"out.shrink(payload_size + %d - frame_size);\n", type_id.header_size);
+			}
+			else
+			{
+				fwprintf(body.file, L"int frame_size = compress_frame(frame, %d);\n", protocol.min_size);
+
+				print_tab(body);
+				fwprintf(body.file, L"out.shrink(%d - frame_size);\n", type_id.header_size + protocol.min_size);
+			}
+		}
+
+		if (integrity.enable && !defer_seal)
+		{
+			print_guard_seal(body, L"frame", packed ? L"frame_size" : sized ? frame_end : nullptr, type_id.header_size + protocol.min_size);
+		}
+
+		if (trace.enable)
+		{
+			fwprintf(body.file, L"\n");
+
+			if (sized && !packed)
+			{
+				print_trace_encode(body, L"frame", L"payload_size", type_id.header_size + integrity.trailer_size);
+			}
+			else
+			{
+				print_trace_encode(body, L"frame", packed ? L"frame_size" : nullptr,
+					packed ? integrity.trailer_size : type_id.header_size + protocol.min_size + integrity.trailer_size);
+			}
+		}
+	}
+
+	// one body per wire shape and encoder kind, the wrappers pass their type as the argument
+	void print_shape(FileInfo& cpp)
+	{
+		wchar_t buffer_type[BUFFER_SIZE];
+		wcscpy_s(buffer_type, BUFFER_SIZE, serial_buffer.type);
+		wcscat_s(buffer_type, BUFFER_SIZE, L"*");
+
+		const wchar_t* first_type[4] = { buffer_type, L"std::span<std::byte>", L"GatherQueue&", L"SendFrame&" };
+		const wchar_t* first_name[4] = { serial_buffer.param, L"out", L"out", L"out" };
+		const wchar_t* result[4] = { L"void", L"size_t", L"void", L"void" };
+		const bool kind_enable[4] = { true, uring.enable, gather.enable, send_queue.enable };
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"namespace\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		shape_body = true;
+
+		for (int kind = 0; kind < 4; ++kind)
+		{
+			if (!kind_enable[kind])
+			{
+				continue;
+			}
+
+			defer_seal = kind == 3 || (kind == 0 && outbox.enable);
+
+			if (kind != 0)
+			{
+				fwprintf(cpp.file, L"\n");
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"RPC_NOINLINE %s encode_shape_%d(%s %s", result[kind], protocol.shape_id, first_type[kind], first_name[kind]);
+
+			if (integrity.enable && !defer_seal)
+			{
+				fwprintf(cpp.file, L", FrameGuard* guard");
+			}
+
+			fwprintf(cpp.file, L", %s type", type_id.name);
+
+			for (int i = 0; i < protocol.param_cnt; ++i)
+			{
+				fwprintf(cpp.file, L", %s %s", protocol.param_type[i], protocol.param_name[i]);
+			}
+
+			fwprintf(cpp.file, L")\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			++cpp.tab_cnt;
+
+			if (kind == 0)
+			{
+				print_buffer_body(cpp);
+			}
+			else if (kind == 1)
+			{
+				print_span_body(cpp);
+			}
+			else
+			{
+				print_gather_body(cpp);
+			}
+
+			--cpp.tab_cnt;
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		shape_body = false;
+		defer_seal = false;
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n\n");
+	}
+
+	void print_shape_call(FileInfo& body, const wchar_t* prefix, const wchar_t* first_name)
+	{
+		print_tab(body);
+		fwprintf(body.file, L"%sencode_shape_%d(%s", prefix, protocol.shape_id, first_name);
+
+		if (integrity.enable && !defer_seal)
+		{
+			fwprintf(body.file, L", guard");
+		}
+
+		fwprintf(body.file, L", %d", protocol.protocol_type);
+
+		for (int i = 0; i < protocol.param_cnt; ++i)
+		{
+			fwprintf(body.file, L", %s", protocol.param_name[i]);
+		}
+
+		fwprintf(body.file, L");\n");
+	}
+
+	// the type as a constant, or the parameter of a shared body
+	void print_type_term(FileInfo& body)
+	{
+		if (shape_body)
+		{
+			fwprintf(body.file, L"static_cast<unsigned int>(type)");
+		}
+		else
+		{
+			fwprintf(body.file, L"%du", protocol.protocol_type);
+		}
+	}
+
+	void print_proxy_signature(FileInfo& header, FileInfo& body, const wchar_t* result, const wchar_t* first_type, const wchar_t* first_name)
+	{
+		if (proxy.inline_body)
+		{
+			print_tab(body);
+			fwprintf(body.file, L"%s mp_%s(%s %s", result, protocol.lower_name, first_type, first_name);
+		}
+		else
+		{
+			print_tab(header);
+			fwprintf(header.file, L"%s mp_%s(%s %s", result, protocol.lower_name, first_type, first_name);
+
+			print_tab(body);
+			fwprintf(body.file, L"%s %s::mp_%s(%s %s", result, RPC_CLASS[PROXY], protocol.lower_name, first_type, first_name);
+		}
+
+		if (integrity.enable && !defer_seal)
+		{
+			if (!proxy.inline_body)
+			{
+				fwprintf(header.file, L", FrameGuard* guard");
+			}
+
+			fwprintf(body.file, L", FrameGuard* guard");
+		}
+
+		for (int i = 0; i < protocol.param_cnt; ++i)
+		{
+			if (!proxy.inline_body)
+			{
+				fwprintf(header.file, L", %s %s", protocol.param_type[i], protocol.param_name[i]);
+			}
+
+			fwprintf(body.file, L", %s %s", protocol.param_type[i], protocol.param_name[i]);
+		}
+
+		if (!proxy.inline_body)
+		{
+			fwprintf(header.file, L");\n");
+		}
+
+		fwprintf(body.file, L")\n");
+	}
+
+	// the buffer cannot shrink in place, so a packed frame is written again from scratch
+	void print_packed_buffer(FileInfo& cpp)
+	{
+		fwprintf(cpp.file, L"\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"thread_local char packed[255];\n\n");
+
+		print_tab(cpp);
+		if (protocol.min_size > compress.threshold)
+		{
+			fwprintf(cpp.file, L"int packed_size = compress_payload(reinterpret_cast<char*>(%s->read_pos()) + %d, %s->size() - %d, packed);\n\n",
+				serial_buffer.param, type_id.header_size, serial_buffer.param, type_id.header_size);
+		}
+		else
+		{
+			fwprintf(cpp.file, L"int packed_size = %s->size() - %d > COMPRESS_THRESHOLD ? compress_payload(reinterpret_cast<char*>(%s->read_pos()) + %d, %s->size() - %d, packed) : 0;\n\n",
+				serial_buffer.param, type_id.header_size, serial_buffer.param, type_id.header_size, serial_buffer.param, type_id.header_size);
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"if (packed_size > 0)\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		if (type_id.bits == 16)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"header = COMPRESSED_CODE | (static_cast<unsigned int>(packed_size) << 8) | (");
+			print_type_term(cpp);
+			fwprintf(cpp.file, L" << 16);\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"%s->clear();\n", serial_buffer.param);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"*%s << header;\n", serial_buffer.param);
+		}
+		else
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"code = COMPRESSED_CODE;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"size = static_cast<unsigned char>(packed_size);\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"%s->clear();\n", serial_buffer.param);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"*%s << code << size << type;\n", serial_buffer.param);
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"%s->%s(packed, packed_size);\n", serial_buffer.param, serial_buffer.put_data);
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n");
+	}
+
+	// the outbox encoders leave the trailer zero, a caller sending their frame straight away seals it itself
+	void print_direct_seal(FileInfo& cpp, const wchar_t* guard, const wchar_t* buffer, const wchar_t* access)
+	{
+		print_tab(cpp);
+		fwprintf(cpp.file, L"\t%s.seal(reinterpret_cast<char*>(%s%sread_pos()), %s%ssize() - %d);\n",
+			guard, buffer, access, buffer, access, TRAILER_SIZE);
+	}
+
+	// size_name names a local holding the size, otherwise size is printed as is
+	void print_guard_seal(FileInfo& cpp, const wchar_t* frame, const wchar_t* size_name, int size)
+	{
+		fwprintf(cpp.file, L"\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"if (guard != nullptr)\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		print_tab(cpp);
+		if (size_name != nullptr)
+		{
+			fwprintf(cpp.file, L"\tguard->seal(%s, %s);\n", frame, size_name);
+		}
+		else
+		{
+			fwprintf(cpp.file, L"\tguard->seal(%s, %d);\n", frame, size);
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n");
+	}
+
+	void print_frame_copy(FileInfo& cpp)
+	{
+		print_tab(cpp);
+		fwprintf(cpp.file, L"memcpy(frame, &header, %d);\n", type_id.header_size);
+
+		int offset = type_id.header_size;
+
+		for (int i = 0; i < protocol.param_cnt; ++i)
+		{
+			print_tab(cpp);
+
+			if (protocol.param_length[i] == 0)
+			{
+				fwprintf(cpp.file, L"memcpy(frame + %d", offset);
+				print_string_term(cpp, i);
+				fwprintf(cpp.file, L", &%s, %d);\n", protocol.param_name[i], protocol.param_size[i]);
+
+				offset += protocol.param_size[i];
+
+				continue;
+			}
+
+			// fields after a string sit behind its characters, an empty view may have no data() to copy from
+			fwprintf(cpp.file, L"memcpy(frame + %d", offset);
+			print_string_term(cpp, i);
+			fwprintf(cpp.file, L", &%s_len, 1);\n\n", protocol.param_name[i]);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"if (%s_len > 0)\n", protocol.param_name[i]);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tmemcpy(frame + %d", offset + 1);
+			print_string_term(cpp, i);
+			fwprintf(cpp.file, protocol.param_size[i] == 2 ? L", %s.data(), %s_len * 2);\n" : L", %s.data(), %s_len);\n",
+				protocol.param_name[i], protocol.param_name[i]);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+
+			if (i != protocol.param_cnt - 1)
+			{
+				fwprintf(cpp.file, L"\n");
+			}
+
+			offset += 1;
+		}
+	}
+
+	// code, size and type as one little-endian word, the size is the encoder's payload_size when strings vary it
+	void print_header_term(FileInfo& body)
+	{
+		print_tab(body);
+		if (has_string(protocol))
+		{
+			fwprintf(body.file, L"unsigned int header = %s | (static_cast<unsigned int>(payload_size) << 8) | (", CODE_VALUE);
+		}
+		else
+		{
+			fwprintf(body.file, L"unsigned int header = %s | (%du << 8) | (", CODE_VALUE, protocol.min_size);
+		}
+
+		print_type_term(body);
+		fwprintf(body.file, L" << 16);\n");
+	}
+
+	// each string's length clamped to its N, then the payload_size they add up to
+	void print_string_length(FileInfo& body, bool payload)
+	{
+		if (!has_string(protocol))
+		{
+			return;
+		}
+
+		for (int i = 0; i < protocol.param_cnt; ++i)
+		{
+			if (protocol.param_length[i] > 0)
+			{
+				print_tab(body);
+				fwprintf(body.file, L"unsigned char %s_len = static_cast<unsigned char>(%s.size() < %d ? %s.size() : %d);\n",
+					protocol.param_name[i], protocol.param_name[i], protocol.param_length[i], protocol.param_name[i], protocol.param_length[i]);
+			}
+		}
+
+		if (payload)
+		{
+			print_tab(body);
+			fwprintf(body.file, L"int payload_size = %d", protocol.min_size);
+			print_string_term(body, protocol.param_cnt);
+			fwprintf(body.file, L";\n");
+		}
+
+		fwprintf(body.file, L"\n");
+	}
+
+	// " + a_len + b_len * 2" for the characters of the strings before param_end
+	void print_string_term(FileInfo& body, int param_end)
+	{
+		for (int i = 0; i < param_end; ++i)
+		{
+			if (protocol.param_length[i] > 0)
+			{
+				fwprintf(body.file, protocol.param_size[i] == 2 ? L" + %s_len * 2" : L" + %s_len", protocol.param_name[i]);
+			}
+		}
+	}
+
+	void print_close()
+	{
+		if (view.enable)
+		{
+			print_view(vwh);
+		}
+
+		if (traits.enable)
+		{
+			print_traits(trh);
+		}
+
+		if (rate_limit.enable)
+		{
+			print_rate(rlh);
+		}
+
+		for (int i = 0; i < profile_cnt; ++i)
+		{
+			if (!profile[i].used)
+			{
+				wprintf(L"profile names no message: %s\n", profile[i].name);
+			}
+		}
+
+		if (bot.enable)
+		{
+			print_bot(bth);
+		}
+
+		if (loopback.enable)
+		{
+			print_loopback(lbc);
+		}
+
+		if (batch_encode.test)
+		{
+			bool encoded = false;
+
+			for (int i = 0; i < protocol_cnt; ++i)
+			{
+				encoded = encoded || is_batch_encoded(protocols[i]);
+			}
+
+			// opened only now, a protocol without [batch] messages would leave nothing to check
+			if (!encoded)
+			{
+				wprintf(L"proxy.batch.test finds no [batch] message, the batch test is not written\n");
+			}
+			else if (!open_shared(btc, L"batch_test", CPP))
+			{
+				wprintf(L"failed open batch_test\n");
+			}
+			else
+			{
+				print_batch_test(btc);
+			}
+		}
+
+		if (decode.string_test)
+		{
+			bool strings = false;
+
+			for (int i = 0; i < protocol_cnt; ++i)
+			{
+				strings = strings || has_string(protocols[i]);
+			}
+
+			if (!strings)
+			{
+				wprintf(L"dispatch.decode.string_test finds no string message, the string test is not written\n");
+			}
+			else if (!open_shared(stc, L"string_test", CPP))
+			{
+				wprintf(L"failed open string_test\n");
+			}
+			else
+			{
+				print_string_test(stc);
+			}
+		}
+
+		if (creation.server_side)
+		{
+			print_close_stub(ssh, ssc);
+			print_close_proxy(sph, spc);
+		}
+
+		if (creation.client_side)
+		{
+			print_close_stub(csh, csc);
+			print_close_proxy(cph, cpc);
+		}
+	}
+
+	void print_close_stub(FileInfo& header, FileInfo& cpp)
+	{
+		if (batch.enable)
+		{
+			print_batch_stub(header);
+		}
+
+		--header.tab_cnt;
+		print_tab(header);
+		fwprintf(header.file, L"};\n"); // class
+
+		if (ns.enable_side)
+		{
+			--header.tab_cnt;
+			print_tab(header);
+			fwprintf(header.file, L"}");
+
+			if (ns.enable)
+			{
+				fwprintf(header.file, L"\n");
+
+				--header.tab_cnt;
+				print_tab(header);
+				fwprintf(header.file, L"}");
+			}
+		}
+		else if (ns.enable)
+		{
+			--header.tab_cnt;
+			print_tab(header);
+			fwprintf(header.file, L"}");
+		}
+
+		// cpp
+
+		print_dispatch_body(cpp);
+
+		if (batch.enable)
+		{
+			print_batch_body(cpp);
+		}
+
+		if (ns.enable_side)
+		{
+			--cpp.tab_cnt;
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}");
+
+			if (ns.enable)
+			{
+				fwprintf(cpp.file, L"\n");
+
+				--cpp.tab_cnt;
+				print_tab(cpp);
+				fwprintf(cpp.file, L"}");
+			}
+		}
+		else if (ns.enable)
+		{
+			--cpp.tab_cnt;
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}");
+		}
+	}
+
+	void print_close_proxy(FileInfo& header, FileInfo& cpp)
+	{
+		--header.tab_cnt;
+		print_tab(header);
+		fwprintf(header.file, L"};\n"); // class
+
+		if (ns.enable_side)
+		{
+			--header.tab_cnt;
+			print_tab(header);
+			fwprintf(header.file, L"}");
+
+			--cpp.tab_cnt;
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}");
+
+			if (ns.enable)
+			{
+				fwprintf(header.file, L"\n");
+
+				--header.tab_cnt;
+				print_tab(header);
+				fwprintf(header.file, L"}");
+
+				fwprintf(cpp.file, L"\n");
+
+				--cpp.tab_cnt;
+				print_tab(cpp);
+				fwprintf(cpp.file, L"}");
+			}
+		}
+		else if (ns.enable)
+		{
+			--header.tab_cnt;
+			print_tab(header);
+			fwprintf(header.file, L"}");
+
+			--cpp.tab_cnt;
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}");
+		}
+	}
+
+	void print_tab(FileInfo& info)
+	{
+		for (int i = 0; i < info.tab_cnt; ++i)
+		{
+			fwprintf(info.file, L"\t");
+		}
+	}
+
+	void print_lines(FileInfo& info, const wchar_t* const* lines, int line_cnt)
+	{
+		for (int i = 0; i < line_cnt; ++i)
+		{
+			if (lines[i][0] != L'\0')
+			{
+				print_tab(info);
+				fwprintf(info.file, L"%s", lines[i]);
+			}
+
+			fwprintf(info.file, L"\n");
+		}
+	}
+
+	bool open_shared(FileInfo& info, const wchar_t* part, int h_c)
+	{
+		info.h_c = h_c;
+		info.filename[0] = L'\0';
+
+		if (creation.global_prefix)
+		{
+			wcscat_s(info.filename, FILENAME_MAX, ns.global);
+			wcscat_s(info.filename, FILENAME_MAX, L"_");
+		}
+
+		wcscat_s(info.filename, FILENAME_MAX, part);
+		wcscat_s(info.filename, FILENAME_MAX, EXTENSION[h_c]);
+
+		if (_wfopen_s(&info.file, info.filename, L"wt, ccs=UNICODE") != 0 ||
+			info.file == nullptr)
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	void print_shared_namespace(FileInfo& info)
+	{
+		if (ns.enable)
+		{
+			fwprintf(info.file, L"namespace %s\n", ns.global);
+			fwprintf(info.file, L"{\n");
+
+			++info.tab_cnt;
+		}
+	}
+
+	void print_shared_close(FileInfo& info)
+	{
+		if (ns.enable)
+		{
+			--info.tab_cnt;
+			fwprintf(info.file, L"}");
+		}
+
+		fclose(info.file);
+		info.file = nullptr;
+	}
+
+	void print_outbox(FileInfo& header)
+	{
+		static const wchar_t* const types[] =
+		{
+			L"enum class Priority : unsigned char",
+			L"{",
+			L"\tHIGH,",
+			L"\tNORMAL,",
+			L"\tLOW,",
+			L"};",
+			L"",
+			L"struct FrameTag",
+			L"{",
+			L"\tPriority priority;",
+			L"\tbool droppable;",
+			L"\tunsigned short group; // coalesce group, 0 = never coalesced",
+			L"\tunsigned long long key;",
+			L"};",
+			L"",
+			L"// per-session send queue, one ring per priority, drained high priority first",
+			L"class Outbox",
+			L"{",
+			L"public:",
+			L"\tstatic constexpr int PRIORITY_CNT = 3;",
+		};
+
+		static const wchar_t* const body[] =
+		{
+			L"",
+			L"private:",
+			L"\tstruct Frame",
+			L"\t{",
+			L"\t\tunsigned short size; // 0 = shed while queued",
+			L"\t\tbool droppable;",
+			L"\t\tunsigned short group;",
+			L"\t\tunsigned long long key;",
+			L"\t\tchar data[FRAME_CAPACITY];",
+			L"\t};",
+			L"",
+			L"\tstruct Coalesce",
+			L"\t{",
+			L"\t\tunsigned short group;",
+			L"\t\tunsigned long long key;",
+			L"",
+			L"\t\tbool operator==(const Coalesce& other) const { return group == other.group && key == other.key; }",
+			L"\t};",
+			L"",
+			L"\tstruct CoalesceHash",
+			L"\t{",
+			L"\t\tsize_t operator()(const Coalesce& coalesce) const",
+			L"\t\t{",
+			L"\t\t\treturn std::hash<unsigned long long>()(coalesce.key * 0x9E3779B97F4A7C15ull ^ coalesce.group);",
+			L"\t\t}",
+			L"\t};",
+			L"",
+			L"\tstruct Pending",
+			L"\t{",
+			L"\t\tint priority;",
+			L"\t\tsize_t seq;",
+			L"\t};",
+			L"",
+			L"\tclass Ring",
+			L"\t{",
+			L"\tpublic:",
+			L"\t\tbool empty() const { return head_ == tail_; }",
+			L"\t\tsize_t head() const { return head_; }",
+			L"\t\tsize_t tail() const { return tail_; }",
+			L"\t\tFrame& at(size_t seq) { return frames_[seq & mask_]; }",
+			L"\t\tFrame& front() { return at(head_); }",
+			L"\t\tvoid pop() { ++head_; }",
+			L"",
+			L"\t\tFrame& push()",
+			L"\t\t{",
+			L"\t\t\tif (tail_ - head_ == frames_.size())",
+			L"\t\t\t{",
+			L"\t\t\t\tgrow();",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\treturn at(tail_++);",
+			L"\t\t}",
+			L"",
+			L"\tprivate:",
+			L"\t\tvoid grow()",
+			L"\t\t{",
+			L"\t\t\tsize_t capacity = frames_.empty() ? 16 : frames_.size() * 2;",
+			L"\t\t\tstd::vector<Frame> frames(capacity);",
+			L"",
+			L"\t\t\tfor (size_t seq = head_; seq != tail_; ++seq)",
+			L"\t\t\t{",
+			L"\t\t\t\tframes[seq & (capacity - 1)] = frames_[seq & mask_];",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tframes_.swap(frames);",
+			L"\t\t\tmask_ = capacity - 1;",
+			L"\t\t}",
+			L"",
+			L"\t\tstd::vector<Frame> frames_;",
+			L"\t\tsize_t mask_ = 0;",
+			L"\t\tsize_t head_ = 0;",
+			L"\t\tsize_t tail_ = 0;",
+			L"\t};",
+			L"",
+			L"public:",
+			L"\texplicit Outbox(size_t drop_threshold = DROP_THRESHOLD) : drop_threshold_(drop_threshold)",
+			L"\t{",
+			L"\t}",
+			L"",
+			L"\t// false when the frame was dropped",
+			L"\tbool push(FrameTag tag, const void* frame, int size)",
+			L"\t{",
+			L"\t\tif (size <= 0 || size > FRAME_CAPACITY)",
+			L"\t\t{",
+			L"\t\t\treturn false;",
+			L"\t\t}",
+			L"",
+			L"\t\tif (tag.group != 0)",
+			L"\t\t{",
+			L"\t\t\tauto found = pending_.find(Coalesce{ tag.group, tag.key });",
+			L"",
+			L"\t\t\tif (found != pending_.end()) // last writer wins, the older frame is never sent",
+			L"\t\t\t{",
+			L"\t\t\t\tFrame& slot = queues_[found->second.priority].at(found->second.seq);",
+			L"\t\t\t\tpending_bytes_ = pending_bytes_ - slot.size + size;",
+			L"\t\t\t\tslot.size = static_cast<unsigned short>(size);",
+			L"\t\t\t\tmemcpy(slot.data, frame, size);",
+			L"",
+			L"\t\t\t\t++coalesced_;",
+			L"\t\t\t\treturn true;",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\tif (pending_bytes_ + size > drop_threshold_)",
+			L"\t\t{",
+			L"\t\t\tif (tag.droppable)",
+			L"\t\t\t{",
+			L"\t\t\t\t++dropped_;",
+			L"\t\t\t\treturn false;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tshed(size);",
+			L"\t\t}",
+			L"",
+			L"\t\tRing& queue = queues_[static_cast<int>(tag.priority)];",
+			L"",
+			L"\t\tif (tag.group != 0)",
+			L"\t\t{",
+			L"\t\t\tpending_.emplace(Coalesce{ tag.group, tag.key }, Pending{ static_cast<int>(tag.priority), queue.tail() });",
+			L"\t\t}",
+			L"",
+			L"\t\tFrame& slot = queue.push();",
+			L"\t\tslot.size = static_cast<unsigned short>(size);",
+			L"\t\tslot.droppable = tag.droppable;",
+			L"\t\tslot.group = tag.group;",
+			L"\t\tslot.key = tag.key;",
+			L"\t\tmemcpy(slot.data, frame, size);",
+			L"",
+			L"\t\tpending_bytes_ += size;",
+			L"",
+			L"\t\treturn true;",
+			L"\t}",
+			L"",
+			L"\t// sink(const char* frame, int size) returns false when it cannot take more",
+			L"\ttemplate <typename Sink>",
+		};
+
+		// frames are queued unsealed, the guard numbers them here in the order they leave
+		static const wchar_t* const sealed_drain[] =
+		{
+			L"\tsize_t drain(Sink&& sink, FrameGuard* guard)",
+			L"\t{",
+			L"\t\tsize_t drained = 0;",
+			L"",
+			L"\t\t// sealed on an earlier drain, nothing sealed after it may overtake it",
+			L"\t\tif (held_.size != 0)",
+			L"\t\t{",
+			L"\t\t\tif (!sink(static_cast<const char*>(held_.data), static_cast<int>(held_.size)))",
+			L"\t\t\t{",
+			L"\t\t\t\treturn drained;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tdrained += held_.size;",
+			L"\t\t\tpending_bytes_ -= held_.size;",
+			L"\t\t\theld_.size = 0;",
+			L"\t\t}",
+			L"",
+			L"\t\tfor (Ring& queue : queues_)",
+			L"\t\t{",
+			L"\t\t\twhile (!queue.empty())",
+			L"\t\t\t{",
+			L"\t\t\t\tFrame& frame = queue.front();",
+			L"",
+			L"\t\t\t\tif (frame.size != 0)",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\tif (guard != nullptr)",
+			L"\t\t\t\t\t{",
+			L"\t\t\t\t\t\tguard->seal(frame.data, frame.size - FrameGuard::TRAILER_SIZE);",
+			L"\t\t\t\t\t}",
+			L"",
+			L"\t\t\t\t\tif (frame.group != 0)",
+			L"\t\t\t\t\t{",
+			L"\t\t\t\t\t\tpending_.erase(Coalesce{ frame.group, frame.key });",
+			L"\t\t\t\t\t}",
+			L"",
+			L"\t\t\t\t\t// its sequence number is spent, so it can no longer be coalesced, shed or reordered",
+			L"\t\t\t\t\tif (!sink(static_cast<const char*>(frame.data), static_cast<int>(frame.size)))",
+			L"\t\t\t\t\t{",
+			L"\t\t\t\t\t\theld_.size = frame.size;",
+			L"\t\t\t\t\t\tmemcpy(held_.data, frame.data, frame.size);",
+			L"\t\t\t\t\t\tqueue.pop();",
+			L"\t\t\t\t\t\treturn drained;",
+			L"\t\t\t\t\t}",
+			L"",
+			L"\t\t\t\t\tdrained += frame.size;",
+			L"\t\t\t\t\tpending_bytes_ -= frame.size;",
+			L"\t\t\t\t}",
+			L"",
+			L"\t\t\t\tqueue.pop();",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\treturn drained;",
+			L"\t}",
+		};
+
+		static const wchar_t* const drain[] =
+		{
+			L"\tsize_t drain(Sink&& sink)",
+			L"\t{",
+			L"\t\tsize_t drained = 0;",
+			L"",
+			L"\t\tfor (Ring& queue : queues_)",
+			L"\t\t{",
+			L"\t\t\twhile (!queue.empty())",
+			L"\t\t\t{",
+			L"\t\t\t\tFrame& frame = queue.front();",
+			L"",
+			L"\t\t\t\tif (frame.size != 0)",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\tif (!sink(static_cast<const char*>(frame.data), static_cast<int>(frame.size)))",
+			L"\t\t\t\t\t{",
+			L"\t\t\t\t\t\treturn drained;",
+			L"\t\t\t\t\t}",
+			L"",
+			L"\t\t\t\t\tdrained += frame.size;",
+			L"\t\t\t\t\tpending_bytes_ -= frame.size;",
+			L"",
+			L"\t\t\t\t\tif (frame.group != 0)",
+			L"\t\t\t\t\t{",
+			L"\t\t\t\t\t\tpending_.erase(Coalesce{ frame.group, frame.key });",
+			L"\t\t\t\t\t}",
+			L"\t\t\t\t}",
+			L"",
+			L"\t\t\t\tqueue.pop();",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\treturn drained;",
+			L"\t}",
+		};
+
+		static const wchar_t* const tail[] =
+		{
+			L"",
+			L"\tsize_t pending_bytes() const { return pending_bytes_; }",
+			L"\tsize_t dropped() const { return dropped_; }",
+			L"\tsize_t coalesced() const { return coalesced_; }",
+			L"",
+			L"private:",
+			L"\t// a reliable frame over the threshold still goes in, queued droppable frames make room for it",
+			L"\tvoid shed(int size)",
+			L"\t{",
+			L"\t\tfor (int priority = PRIORITY_CNT - 1; priority >= 0; --priority)",
+			L"\t\t{",
+			L"\t\t\tRing& queue = queues_[priority];",
+			L"",
+			L"\t\t\tfor (size_t seq = queue.head(); seq != queue.tail(); ++seq)",
+			L"\t\t\t{",
+			L"\t\t\t\tif (pending_bytes_ + size <= drop_threshold_)",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\treturn;",
+			L"\t\t\t\t}",
+			L"",
+			L"\t\t\t\tFrame& frame = queue.at(seq);",
+			L"",
+			L"\t\t\t\tif (frame.droppable && frame.size != 0)",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\tpending_bytes_ -= frame.size;",
+			L"\t\t\t\t\tframe.size = 0;",
+			L"\t\t\t\t\t++dropped_;",
+			L"",
+			L"\t\t\t\t\tif (frame.group != 0)",
+			L"\t\t\t\t\t{",
+			L"\t\t\t\t\t\tpending_.erase(Coalesce{ frame.group, frame.key });",
+			L"\t\t\t\t\t}",
+			L"\t\t\t\t}",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tRing queues_[PRIORITY_CNT];",
+			L"\tstd::unordered_map<Coalesce, Pending, CoalesceHash> pending_;",
+			L"\tsize_t drop_threshold_;",
+			L"\tsize_t pending_bytes_ = 0;",
+			L"\tsize_t dropped_ = 0;",
+			L"\tsize_t coalesced_ = 0;",
+		};
+
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, L"#include <cstddef>\n#include <cstring>\n#include <unordered_map>\n#include <vector>\n\n");
+
+		if (integrity.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n\n", igh.filename);
+		}
+
+		print_shared_namespace(header);
+
+		print_lines(header, types, sizeof(types) / sizeof(types[0]));
+
+		print_tab(header);
+		fwprintf(header.file, L"\tstatic constexpr int FRAME_CAPACITY = %d;\n", type_id.header_size + 255 + integrity.trailer_size);
+
+		print_tab(header);
+		fwprintf(header.file, L"\tstatic constexpr size_t DROP_THRESHOLD = %d;\n", outbox.drop_threshold);
+
+		print_lines(header, body, sizeof(body) / sizeof(body[0]));
+
+		if (integrity.enable)
+		{
+			print_lines(header, sealed_drain, sizeof(sealed_drain) / sizeof(sealed_drain[0]));
+		}
+		else
+		{
+			print_lines(header, drain, sizeof(drain) / sizeof(drain[0]));
+		}
+
+		print_lines(header, tail, sizeof(tail) / sizeof(tail[0]));
+
+		if (integrity.enable)
+		{
+			print_tab(header);
+			fwprintf(header.file, L"\tFrame held_{}; // refused by the sink after it was sealed\n");
+		}
+
+		print_tab(header);
+		fwprintf(header.file, L"};\n");
+
+		print_shared_close(header);
+	}
+
+	void print_mpsc(FileInfo& header)
+	{
+		static const wchar_t* const body[] =
+		{
+			L"// intrusive multi-producer single-consumer queue, Node needs std::atomic<Node*> next",
+			L"template <typename Node>",
+			L"class MpscQueue",
+			L"{",
+			L"public:",
+			L"\tMpscQueue() : head_(&stub_), tail_(&stub_)",
+			L"\t{",
+			L"\t\tstub_.next.store(nullptr, std::memory_order_relaxed);",
+			L"\t}",
+			L"",
+			L"\tMpscQueue(const MpscQueue&) = delete;",
+			L"\tMpscQueue& operator=(const MpscQueue&) = delete;",
+			L"",
+			L"\t// any thread, one atomic exchange",
+			L"\tvoid push(Node* node)",
+			L"\t{",
+			L"\t\tpush(node, node);",
+			L"\t}",
+			L"",
+			L"\t// first..last already linked through next, still one atomic exchange",
+			L"\tvoid push(Node* first, Node* last)",
+			L"\t{",
+			L"\t\tlast->next.store(nullptr, std::memory_order_relaxed);",
+			L"",
+			L"\t\tNode* prev = head_.exchange(last, std::memory_order_acq_rel);",
+			L"\t\tprev->next.store(first, std::memory_order_release);",
+			L"\t}",
+			L"",
+			L"\t// consumer only, nullptr when empty or a producer is between exchange and link",
+			L"\tNode* pop()",
+			L"\t{",
+			L"\t\tNode* tail = tail_;",
+			L"\t\tNode* next = tail->next.load(std::memory_order_acquire);",
+			L"",
+			L"\t\tif (tail == &stub_)",
+			L"\t\t{",
+			L"\t\t\tif (next == nullptr)",
+			L"\t\t\t{",
+			L"\t\t\t\treturn nullptr;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\ttail_ = next;",
+			L"\t\t\ttail = next;",
+			L"\t\t\tnext = next->next.load(std::memory_order_acquire);",
+			L"\t\t}",
+			L"",
+			L"\t\tif (next != nullptr)",
+			L"\t\t{",
+			L"\t\t\ttail_ = next;",
+			L"\t\t\treturn tail;",
+			L"\t\t}",
+			L"",
+			L"\t\tif (tail != head_.load(std::memory_order_acquire))",
+			L"\t\t{",
+			L"\t\t\treturn nullptr;",
+			L"\t\t}",
+			L"",
+			L"\t\tpush(&stub_);",
+			L"",
+			L"\t\tnext = tail->next.load(std::memory_order_acquire);",
+			L"\t\tif (next != nullptr)",
+			L"\t\t{",
+			L"\t\t\ttail_ = next;",
+			L"\t\t\treturn tail;",
+			L"\t\t}",
+			L"",
+			L"\t\treturn nullptr;",
+			L"\t}",
+			L"",
+			L"\t// consumer only, false while a producer is mid-push",
+			L"\tbool empty() const",
+			L"\t{",
+			L"\t\treturn tail_ == &stub_ && head_.load(std::memory_order_seq_cst) == &stub_;",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\talignas(64) std::atomic<Node*> head_;",
+			L"\talignas(64) Node* tail_;",
+			L"\tNode stub_;",
+			L"};",
+		};
+
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, L"#include <atomic>\n\n");
+
+		print_shared_namespace(header);
+
+		print_lines(header, body, sizeof(body) / sizeof(body[0]));
+
+		print_shared_close(header);
+	}
+
+	void print_shard(FileInfo& header)
+	{
+		static const wchar_t* const head[] =
+		{
+			L"// hashes each session onto one worker shard, frames of one session stay in order on that shard",
+			L"template <typename Stub, typename Session>",
+			L"class ShardedDispatcher",
+			L"{",
+			L"public:",
+		};
+
+		static const wchar_t* const body[] =
+		{
+			L"",
+			L"\tusing Reject = void (*)(Session* session, Type type);",
+			L"",
+			L"private:",
+			L"\tstruct Frame",
+			L"\t{",
+			L"\t\tstd::atomic<Frame*> next;",
+			L"\t\tSession* session;",
+			L"\t\tType type;",
+			L"\t\tunsigned short size;",
+			L"\t\tchar payload[PAYLOAD_CAPACITY];",
+			L"\t};",
+			L"",
+			L"\tstruct alignas(64) Shard",
+			L"\t{",
+			L"\t\tMpscQueue<Frame> queue;",
+			L"\t\tstd::atomic<bool> sleeping{ false };",
+			L"\t\tStub* stub = nullptr;",
+			L"\t\tstd::thread worker;",
+			L"\t};",
+			L"",
+			L"public:",
+			L"\t// one stub per shard, the same stub may be passed for every shard if its handlers are thread-safe",
+			L"\tShardedDispatcher(const std::vector<Stub*>& stubs, Reject reject = nullptr)",
+			L"\t\t: shards_(stubs.size()), reject_(reject)",
+			L"\t{",
+			L"\t\tfor (size_t i = 0; i < stubs.size(); ++i)",
+			L"\t\t{",
+			L"\t\t\tshards_[i].stub = stubs[i];",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\t~ShardedDispatcher()",
+			L"\t{",
+			L"\t\tstop();",
+			L"",
+			L"\t\tfor (Shard& shard : shards_)",
+			L"\t\t{",
+			L"\t\t\twhile (Frame* frame = shard.queue.pop())",
+			L"\t\t\t{",
+			L"\t\t\t\tdelete frame;",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\tfor (Frame* frame : pool_)",
+			L"\t\t{",
+			L"\t\t\tdelete frame;",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tShardedDispatcher(const ShardedDispatcher&) = delete;",
+			L"\tShardedDispatcher& operator=(const ShardedDispatcher&) = delete;",
+			L"",
+			L"\tvoid start()",
+			L"\t{",
+			L"\t\trunning_.store(true);",
+			L"",
+			L"\t\tfor (Shard& shard : shards_)",
+			L"\t\t{",
+			L"\t\t\tshard.worker = std::thread([this, &shard]() { run(shard); });",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tvoid stop()",
+			L"\t{",
+			L"\t\tif (!running_.exchange(false))",
+			L"\t\t{",
+			L"\t\t\treturn;",
+			L"\t\t}",
+			L"",
+			L"\t\tfor (Shard& shard : shards_)",
+			L"\t\t{",
+			L"\t\t\tshard.sleeping.store(false);",
+			L"\t\t\tshard.sleeping.notify_one();",
+			L"\t\t\tshard.worker.join();",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tsize_t shard_of(const Session* session) const",
+			L"\t{",
+			L"\t\tunsigned long long hash = reinterpret_cast<uintptr_t>(session) * 0x9E3779B97F4A7C15ull;",
+			L"",
+			L"\t\treturn static_cast<size_t>(hash >> 32) % shards_.size();",
+			L"\t}",
+			L"",
+			L"\t// frames collected by one receive pass, handed to each shard with a single exchange",
+			L"\tclass Batch",
+			L"\t{",
+			L"\tpublic:",
+			L"\t\texplicit Batch(ShardedDispatcher& owner) : owner_(owner), chains_(owner.shards_.size())",
+			L"\t\t{",
+			L"\t\t}",
+			L"",
+			L"\t\t~Batch()",
+			L"\t\t{",
+			L"\t\t\tflush();",
+			L"\t\t}",
+			L"",
+			L"\t\tbool add(Session* session, Type type, const char* payload, int size)",
+			L"\t\t{",
+			L"\t\t\tFrame* frame = owner_.make(session, type, payload, size);",
+			L"\t\t\tif (frame == nullptr)",
+			L"\t\t\t{",
+			L"\t\t\t\treturn false;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tChain& chain = chains_[owner_.shard_of(session)];",
+			L"\t\t\tif (chain.first == nullptr)",
+			L"\t\t\t{",
+			L"\t\t\t\tchain.first = frame;",
+			L"\t\t\t}",
+			L"\t\t\telse",
+			L"\t\t\t{",
+			L"\t\t\t\tchain.last->next.store(frame, std::memory_order_relaxed);",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tchain.last = frame;",
+			L"",
+			L"\t\t\treturn true;",
+			L"\t\t}",
+			L"",
+			L"\t\tvoid flush()",
+			L"\t\t{",
+			L"\t\t\tfor (size_t i = 0; i < chains_.size(); ++i)",
+			L"\t\t\t{",
+			L"\t\t\t\tif (chains_[i].first != nullptr)",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\towner_.publish(owner_.shards_[i], chains_[i].first, chains_[i].last);",
+			L"\t\t\t\t\tchains_[i] = Chain{};",
+			L"\t\t\t\t}",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\tprivate:",
+			L"\t\tstruct Chain",
+			L"\t\t{",
+			L"\t\t\tFrame* first = nullptr;",
+			L"\t\t\tFrame* last = nullptr;",
+			L"\t\t};",
+			L"",
+			L"\t\tShardedDispatcher& owner_;",
+			L"\t\tstd::vector<Chain> chains_;",
+			L"\t};",
+			L"",
+			L"\tbool post(Session* session, Type type, const char* payload, int size)",
+			L"\t{",
+			L"\t\tFrame* frame = make(session, type, payload, size);",
+			L"\t\tif (frame == nullptr)",
+			L"\t\t{",
+			L"\t\t\treturn false;",
+			L"\t\t}",
+			L"",
+			L"\t\tpublish(shards_[shard_of(session)], frame, frame);",
+			L"",
+			L"\t\treturn true;",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tFrame* make(Session* session, Type type, const char* payload, int size)",
+			L"\t{",
+			L"\t\tif (size < 0 || size > PAYLOAD_CAPACITY)",
+			L"\t\t{",
+			L"\t\t\treturn nullptr;",
+			L"\t\t}",
+			L"",
+			L"\t\tFrame* frame = acquire();",
+			L"\t\tframe->session = session;",
+			L"\t\tframe->type = type;",
+			L"\t\tframe->size = static_cast<unsigned short>(size);",
+			L"\t\tmemcpy(frame->payload, payload, size);",
+			L"",
+			L"\t\treturn frame;",
+			L"\t}",
+			L"",
+			L"\tvoid publish(Shard& shard, Frame* first, Frame* last)",
+			L"\t{",
+			L"\t\tshard.queue.push(first, last);",
+			L"",
+			L"\t\tstd::atomic_thread_fence(std::memory_order_seq_cst);",
+			L"",
+			L"\t\tif (shard.sleeping.load(std::memory_order_relaxed))",
+			L"\t\t{",
+			L"\t\t\tshard.sleeping.store(false, std::memory_order_relaxed);",
+			L"\t\t\tshard.sleeping.notify_one();",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tvoid run(Shard& shard)",
+			L"\t{",
+			L"\t\tstd::vector<Frame*> done;",
+			L"\t\tdone.reserve(BATCH_SIZE);",
+			L"",
+			L"\t\twhile (running_.load(std::memory_order_relaxed))",
+			L"\t\t{",
+			L"\t\t\twhile (done.size() < BATCH_SIZE)",
+			L"\t\t\t{",
+			L"\t\t\t\tFrame* frame = shard.queue.pop();",
+			L"\t\t\t\tif (frame == nullptr)",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\tbreak;",
+			L"\t\t\t\t}",
+			L"",
+			L"\t\t\t\tif (!shard.stub->dispatch(frame->session, frame->type, frame->payload, frame->size) && reject_ != nullptr)",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\treject_(frame->session, frame->type);",
+			L"\t\t\t\t}",
+			L"",
+			L"\t\t\t\tdone.push_back(frame);",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tif (!done.empty())",
+			L"\t\t\t{",
+			L"\t\t\t\trelease(done);",
+			L"\t\t\t\tdone.clear();",
+			L"\t\t\t\tcontinue;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tshard.sleeping.store(true);",
+			L"\t\t\tstd::atomic_thread_fence(std::memory_order_seq_cst);",
+			L"",
+			L"\t\t\tif (shard.queue.empty() && running_.load())",
+			L"\t\t\t{",
+			L"\t\t\t\tshard.sleeping.wait(true);",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tshard.sleeping.store(false, std::memory_order_relaxed);",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\t// frames move between threads in batches, so the pool lock is taken once per BATCH_SIZE frames",
+			L"\tFrame* acquire()",
+			L"\t{",
+			L"\t\tstruct Cache",
+			L"\t\t{",
+			L"\t\t\t~Cache()",
+			L"\t\t\t{",
+			L"\t\t\t\tfor (Frame* frame : frames)",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\tdelete frame;",
+			L"\t\t\t\t}",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tstd::vector<Frame*> frames;",
+			L"\t\t};",
+			L"",
+			L"\t\tthread_local Cache cache;",
+			L"",
+			L"\t\tif (cache.frames.empty())",
+			L"\t\t{",
+			L"\t\t\tstd::lock_guard<std::mutex> lock(pool_lock_);",
+			L"",
+			L"\t\t\tsize_t cnt = pool_.size() < BATCH_SIZE ? pool_.size() : BATCH_SIZE;",
+			L"\t\t\tcache.frames.assign(pool_.end() - cnt, pool_.end());",
+			L"\t\t\tpool_.resize(pool_.size() - cnt);",
+			L"\t\t}",
+			L"",
+			L"\t\tif (cache.frames.empty())",
+			L"\t\t{",
+			L"\t\t\treturn new Frame();",
+			L"\t\t}",
+			L"",
+			L"\t\tFrame* frame = cache.frames.back();",
+			L"\t\tcache.frames.pop_back();",
+			L"",
+			L"\t\treturn frame;",
+			L"\t}",
+			L"",
+			L"\tvoid release(const std::vector<Frame*>& frames)",
+			L"\t{",
+			L"\t\tstd::lock_guard<std::mutex> lock(pool_lock_);",
+			L"",
+			L"\t\tpool_.insert(pool_.end(), frames.begin(), frames.end());",
+			L"\t}",
+			L"",
+			L"\tstd::vector<Shard> shards_;",
+			L"\tReject reject_;",
+			L"\tstd::atomic<bool> running_{ false };",
+			L"\tstd::mutex pool_lock_;",
+			L"\tstd::vector<Frame*> pool_;",
+			L"};",
+		};
+
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, L"#include \"%s\"\n\n", mqh.filename);
+		fwprintf(header.file, L"#include <atomic>\n#include <cstdint>\n#include <cstring>\n#include <mutex>\n#include <thread>\n#include <vector>\n\n");
+
+		print_shared_namespace(header);
+
+		print_lines(header, head, sizeof(head) / sizeof(head[0]));
+
+		print_tab(header);
+		fwprintf(header.file, L"\tusing Type = %s;\n\n", type_id.name);
+
+		print_tab(header);
+		fwprintf(header.file, L"\tstatic constexpr int PAYLOAD_CAPACITY = 255;\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"\tstatic constexpr size_t BATCH_SIZE = %d;\n", shard.batch);
+
+		print_lines(header, body, sizeof(body) / sizeof(body[0]));
+
+		print_shared_close(header);
+	}
+
+	void print_task(FileInfo& header)
+	{
+		static const wchar_t* const head[] =
+		{
+			L"// per-session allocator for coroutine frames, not thread-safe: resume handlers on the session's thread",
+			L"class FramePool",
+			L"{",
+			L"public:",
+		};
+
+		static const wchar_t* const body[] =
+		{
+			L"",
+			L"\tFramePool() = default;",
+			L"\tFramePool(const FramePool&) = delete;",
+			L"\tFramePool& operator=(const FramePool&) = delete;",
+			L"",
+			L"\t~FramePool()",
+			L"\t{",
+			L"\t\twhile (free_ != nullptr)",
+			L"\t\t{",
+			L"\t\t\tBlock* next = free_->next;",
+			L"\t\t\t::operator delete(free_);",
+			L"\t\t\tfree_ = next;",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tvoid* allocate(size_t size)",
+			L"\t{",
+			L"\t\tif (size > BLOCK_SIZE)",
+			L"\t\t{",
+			L"\t\t\treturn ::operator new(size);",
+			L"\t\t}",
+			L"",
+			L"\t\tif (free_ == nullptr)",
+			L"\t\t{",
+			L"\t\t\treturn ::operator new(BLOCK_SIZE);",
+			L"\t\t}",
+			L"",
+			L"\t\tBlock* block = free_;",
+			L"\t\tfree_ = block->next;",
+			L"",
+			L"\t\treturn block;",
+			L"\t}",
+			L"",
+			L"\tvoid deallocate(void* memory, size_t size)",
+			L"\t{",
+			L"\t\tif (size > BLOCK_SIZE)",
+			L"\t\t{",
+			L"\t\t\t::operator delete(memory);",
+			L"\t\t\treturn;",
+			L"\t\t}",
+			L"",
+			L"\t\tBlock* block = static_cast<Block*>(memory);",
+			L"\t\tblock->next = free_;",
+			L"\t\tfree_ = block;",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tstruct Block",
+			L"\t{",
+			L"\t\tBlock* next;",
+			L"\t};",
+			L"",
+			L"\tBlock* free_ = nullptr;",
+			L"};",
+			L"",
+			L"// resumes suspended handlers on the logic thread: schedule() queues from any thread, the logic thread calls resume_scheduled()",
+			L"class Scheduler",
+			L"{",
+			L"public:",
+			L"\tvirtual ~Scheduler() {}",
+			L"",
+			L"\t// any thread",
+			L"\tvirtual void schedule(std::coroutine_handle<> handle)",
+			L"\t{",
+			L"\t\tstd::lock_guard<std::mutex> lock(lock_);",
+			L"\t\tscheduled_.push_back(handle);",
+			L"\t}",
+			L"",
+			L"\t// logic thread, handlers scheduled while these run wait for the next call",
+			L"\tvoid resume_scheduled()",
+			L"\t{",
+			L"\t\t{",
+			L"\t\t\tstd::lock_guard<std::mutex> lock(lock_);",
+			L"\t\t\tresuming_.swap(scheduled_);",
+			L"\t\t}",
+			L"",
+			L"\t\tfor (std::coroutine_handle<> handle : resuming_)",
+			L"\t\t{",
+			L"\t\t\thandle.resume();",
+			L"\t\t}",
+			L"",
+			L"\t\tresuming_.clear();",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tstd::mutex lock_;",
+			L"\tstd::vector<std::coroutine_handle<>> scheduled_;",
+			L"\tstd::vector<std::coroutine_handle<>> resuming_;",
+			L"};",
+			L"",
+			L"// handler result: finishes inline like a bool, or suspends and reports through Stub::complete()",
+			L"class [[nodiscard]] Task",
+			L"{",
+			L"public:",
+			L"\tstruct promise_type",
+			L"\t{",
+			L"\t\tpromise_type() = default;",
+			L"",
+			L"\t\t// frames of member handlers come from frame_pool(session), found by ADL on the session type",
+			L"\t\ttemplate <typename Owner, typename Session, typename... Args>",
+			L"\t\tpromise_type(Owner& owner, Session* session, Args&...)",
+			L"\t\t\t: owner(&owner), session(session),",
+			L"\t\t\tcomplete([](void* owner, void* session, bool result)",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\tstatic_cast<std::remove_reference_t<Owner>*>(owner)->complete(static_cast<Session*>(session), result);",
+			L"\t\t\t\t})",
+			L"\t\t{",
+			L"\t\t}",
+			L"",
+			L"\t\ttemplate <typename Owner, typename Session, typename... Args>",
+			L"\t\tstatic void* operator new(size_t size, Owner&, Session* session, Args&...)",
+			L"\t\t{",
+			L"\t\t\tFramePool* pool = &frame_pool(session);",
+			L"",
+			L"\t\t\tvoid* memory = pool->allocate(size + FRAME_HEADER);",
+			L"\t\t\t*static_cast<FramePool**>(memory) = pool;",
+			L"",
+			L"\t\t\treturn static_cast<char*>(memory) + FRAME_HEADER;",
+			L"\t\t}",
+			L"",
+			L"\t\tstatic void* operator new(size_t size)",
+			L"\t\t{",
+			L"\t\t\tvoid* memory = ::operator new(size + FRAME_HEADER);",
+			L"\t\t\t*static_cast<FramePool**>(memory) = nullptr;",
+			L"",
+			L"\t\t\treturn static_cast<char*>(memory) + FRAME_HEADER;",
+			L"\t\t}",
+			L"",
+			L"\t\tstatic void operator delete(void* frame, size_t size)",
+			L"\t\t{",
+			L"\t\t\tvoid* memory = static_cast<char*>(frame) - FRAME_HEADER;",
+			L"\t\t\tFramePool* pool = *static_cast<FramePool**>(memory);",
+			L"",
+			L"\t\t\tif (pool != nullptr)",
+			L"\t\t\t{",
+			L"\t\t\t\tpool->deallocate(memory, size + FRAME_HEADER);",
+			L"\t\t\t}",
+			L"\t\t\telse",
+			L"\t\t\t{",
+			L"\t\t\t\t::operator delete(memory);",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\tTask get_return_object()",
+			L"\t\t{",
+			L"\t\t\treturn Task(std::coroutine_handle<promise_type>::from_promise(*this));",
+			L"\t\t}",
+			L"",
+			L"\t\tstd::suspend_never initial_suspend() noexcept",
+			L"\t\t{",
+			L"\t\t\treturn {};",
+			L"\t\t}",
+			L"",
+			L"\t\tauto final_suspend() noexcept",
+			L"\t\t{",
+			L"\t\t\tstruct Final",
+			L"\t\t\t{",
+			L"\t\t\t\tbool await_ready() noexcept",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\treturn false;",
+			L"\t\t\t\t}",
+			L"",
+			L"\t\t\t\t// a detached frame reports and frees itself, an owned one waits for ~Task",
+			L"\t\t\t\tbool await_suspend(std::coroutine_handle<promise_type> handle) noexcept",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\tpromise_type& promise = handle.promise();",
+			L"",
+			L"\t\t\t\t\tif (!promise.detached)",
+			L"\t\t\t\t\t{",
+			L"\t\t\t\t\t\treturn true;",
+			L"\t\t\t\t\t}",
+			L"",
+			L"\t\t\t\t\tif (promise.complete != nullptr)",
+			L"\t\t\t\t\t{",
+			L"\t\t\t\t\t\tpromise.complete(promise.owner, promise.session, promise.result);",
+			L"\t\t\t\t\t}",
+			L"",
+			L"\t\t\t\t\thandle.destroy();",
+			L"",
+			L"\t\t\t\t\treturn true;",
+			L"\t\t\t\t}",
+			L"",
+			L"\t\t\t\tvoid await_resume() noexcept",
+			L"\t\t\t\t{",
+			L"\t\t\t\t}",
+			L"\t\t\t};",
+			L"",
+			L"\t\t\treturn Final{};",
+			L"\t\t}",
+			L"",
+			L"\t\tvoid return_value(bool value)",
+			L"\t\t{",
+			L"\t\t\tresult = value;",
+			L"\t\t}",
+			L"",
+			L"\t\tvoid unhandled_exception()",
+			L"\t\t{",
+			L"\t\t\tresult = false;",
+			L"\t\t}",
+			L"",
+			L"\t\tvoid* owner = nullptr;",
+			L"\t\tvoid* session = nullptr;",
+			L"\t\tvoid (*complete)(void* owner, void* session, bool result) = nullptr;",
+			L"\t\tbool result = false;",
+			L"\t\tbool detached = false;",
+			L"\t};",
+			L"",
+			L"\tTask(Task&& other) noexcept : handle_(other.handle_), result_(other.result_)",
+			L"\t{",
+			L"\t\tother.handle_ = nullptr;",
+			L"\t}",
+			L"",
+			L"\tTask& operator=(Task&&) = delete;",
+			L"",
+			L"\t~Task()",
+			L"\t{",
+			L"\t\tif (handle_)",
+			L"\t\t{",
+			L"\t\t\thandle_.destroy();",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\t// handlers that never suspend return Task::ready(result) without a coroutine frame",
+			L"\tstatic Task ready(bool result)",
+			L"\t{",
+			L"\t\treturn Task(result);",
+			L"\t}",
+			L"",
+			L"\t// called by dispatch: the finished result, or true once the handler has suspended",
+			L"\tbool run()",
+			L"\t{",
+			L"\t\tif (!handle_)",
+			L"\t\t{",
+			L"\t\t\treturn result_;",
+			L"\t\t}",
+			L"",
+			L"\t\tif (handle_.done())",
+			L"\t\t{",
+			L"\t\t\treturn handle_.promise().result;",
+			L"\t\t}",
+			L"",
+			L"\t\thandle_.promise().detached = true;",
+			L"\t\thandle_ = nullptr;",
+			L"",
+			L"\t\treturn true;",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tstatic constexpr size_t FRAME_HEADER = alignof(std::max_align_t);",
+			L"",
+			L"\texplicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle)",
+			L"\t{",
+			L"\t}",
+			L"",
+			L"\texplicit Task(bool result) : result_(result)",
+			L"\t{",
+			L"\t}",
+			L"",
+			L"\tstd::coroutine_handle<promise_type> handle_;",
+			L"\tbool result_ = false;",
+			L"};",
+			L"",
+			L"// completion slot for an async lookup: co_await it in a handler, complete() it from any thread",
+			L"template <typename T>",
+			L"class Deferred",
+			L"{",
+			L"public:",
+			L"\texplicit Deferred(Scheduler& scheduler) : scheduler_(scheduler)",
+			L"\t{",
+			L"\t}",
+			L"",
+			L"\tvoid complete(T value)",
+			L"\t{",
+			L"\t\tvalue_ = std::move(value);",
+			L"",
+			L"\t\tif (state_.exchange(COMPLETED, std::memory_order_acq_rel) == SUSPENDED)",
+			L"\t\t{",
+			L"\t\t\tscheduler_.schedule(handle_);",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tbool await_ready() const noexcept",
+			L"\t{",
+			L"\t\treturn state_.load(std::memory_order_acquire) == COMPLETED;",
+			L"\t}",
+			L"",
+			L"\tbool await_suspend(std::coroutine_handle<> handle) noexcept",
+			L"\t{",
+			L"\t\thandle_ = handle;",
+			L"",
+			L"\t\tint expected = WAITING;",
+			L"\t\treturn state_.compare_exchange_strong(expected, SUSPENDED, std::memory_order_acq_rel);",
+			L"\t}",
+			L"",
+			L"\tT await_resume()",
+			L"\t{",
+			L"\t\treturn std::move(value_);",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tstatic constexpr int WAITING = 0;",
+			L"\tstatic constexpr int SUSPENDED = 1;",
+			L"\tstatic constexpr int COMPLETED = 2;",
+			L"",
+			L"\tScheduler& scheduler_;",
+			L"\tstd::coroutine_handle<> handle_;",
+			L"\tstd::atomic<int> state_{ WAITING };",
+			L"\tT value_{};",
+			L"};",
+		};
+
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, L"#include <atomic>\n#include <coroutine>\n#include <cstddef>\n#include <mutex>\n#include <new>\n#include <type_traits>\n#include <utility>\n#include <vector>\n\n");
+
+		print_shared_namespace(header);
+
+		print_lines(header, head, sizeof(head) / sizeof(head[0]));
+
+		print_tab(header);
+		fwprintf(header.file, L"\tstatic constexpr size_t BLOCK_SIZE = %d;\n", coroutine.block_size);
+
+		print_lines(header, body, sizeof(body) / sizeof(body[0]));
+
+		print_shared_close(header);
+	}
+
+	void print_view(FileInfo& header)
+	{
+		static const wchar_t* const base[] =
+		{
+			L"// read-only window over a received payload, valid only while the receive buffer is",
+			L"class View",
+			L"{",
+			L"public:",
+			L"\texplicit View(const char* payload) : payload_(payload)",
+			L"\t{",
+			L"\t}",
+			L"",
+			L"\tconst char* data() const",
+			L"\t{",
+			L"\t\treturn payload_;",
+			L"\t}",
+			L"",
+			L"protected:",
+			L"\t// unaligned-safe, compiles to a plain load",
+			L"\ttemplate <typename T>",
+			L"\tT read(int offset) const",
+			L"\t{",
+			L"\t\tT value;",
+			L"\t\tmemcpy(&value, payload_ + offset, sizeof(T));",
+			L"",
+			L"\t\treturn value;",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tconst char* payload_;",
+			L"};",
+		};
+
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, type_map.enable ? L"#include <cstdint>\n#include <cstring>\n\n" : L"#define WIN32_LEAN_AND_MEAN\n#include <Windows.h>\n\n#include <cstring>\n\n");
+
+		print_shared_namespace(header);
+
+		print_lines(header, base, sizeof(base) / sizeof(base[0]));
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			const Protocol& info = protocols[i];
+
+			fwprintf(header.file, L"\n");
+
+			print_tab(header);
+			fwprintf(header.file, L"// %s\n", info.name);
+
+			print_tab(header);
+			fwprintf(header.file, L"class %sView : public View\n", info.class_name);
+
+			print_tab(header);
+			fwprintf(header.file, L"{\n");
+
+			print_tab(header);
+			fwprintf(header.file, L"public:\n");
+
+			++header.tab_cnt;
+
+			print_tab(header);
+			fwprintf(header.file, L"static constexpr int SIZE = %d;\n", info.min_size);
+
+			int offset = 0;
+			wchar_t upper_name[MAX_PARAMETER_CNT][BUFFER_SIZE];
+
+			for (int j = 0; j < info.param_cnt; ++j)
+			{
+				int k = 0;
+				for (; info.param_name[j][k] != L'\0'; ++k)
+				{
+					upper_name[j][k] = towupper(info.param_name[j][k]);
+				}
+				upper_name[j][k] = L'\0';
+
+				print_tab(header);
+				fwprintf(header.file, L"static constexpr int %s_OFFSET = %d;\n", upper_name[j], offset);
+
+				offset += info.param_size[j];
+			}
+
+			fwprintf(header.file, L"\n");
+
+			print_tab(header);
+			fwprintf(header.file, L"using View::View;\n");
+
+			for (int j = 0; j < info.param_cnt; ++j)
+			{
+				fwprintf(header.file, L"\n");
+
+				print_tab(header);
+				fwprintf(header.file, L"%s %s() const\n", info.param_type[j], info.param_name[j]);
+
+				print_tab(header);
+				fwprintf(header.file, L"{\n");
+
+				print_tab(header);
+				fwprintf(header.file, L"\treturn read<%s>(%s_OFFSET);\n", info.param_type[j], upper_name[j]);
+
+				print_tab(header);
+				fwprintf(header.file, L"}\n");
+			}
+
+			--header.tab_cnt;
+
+			print_tab(header);
+			fwprintf(header.file, L"};\n");
+		}
+
+		print_shared_close(header);
+	}
+
+	void print_traits(FileInfo& header)
+	{
+		static const wchar_t* const head[] =
+		{
+			L"// message direction, same as the protocol name prefix",
+			L"enum class Direction : uint8_t",
+			L"{",
+			L"\tSC, // server -> client",
+			L"\tCS, // client -> server",
+			L"};",
+			L"",
+			L"template <typename... T>",
+			L"struct TypeList",
+			L"{",
+			L"\tstatic constexpr size_t COUNT = sizeof...(T);",
+			L"};",
+			L"",
+			L"template <MsgType>",
+			L"struct MessageTraits;",
+		};
+
+		const wchar_t* index_type = type_id.bits == 16 ? L"uint16_t" : L"uint8_t";
+
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, type_map.enable ? L"#include <cstddef>\n#include <cstdint>\n\n" : L"#define WIN32_LEAN_AND_MEAN\n#include <Windows.h>\n\n#include <cstddef>\n#include <cstdint>\n\n");
+
+		print_shared_namespace(header);
+
+		print_tab(header);
+		fwprintf(header.file, L"enum class MsgType : %s\n", index_type);
+
+		print_tab(header);
+		fwprintf(header.file, L"{\n");
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			print_tab(header);
+			fwprintf(header.file, L"\t%s = %d,\n", protocols[i].name, protocols[i].protocol_type);
+		}
+
+		print_tab(header);
+		fwprintf(header.file, L"};\n\n");
+
+		print_lines(header, head, sizeof(head) / sizeof(head[0]));
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			const Protocol& info = protocols[i];
+
+			fwprintf(header.file, L"\n");
+
+			print_tab(header);
+			fwprintf(header.file, L"template <>\n");
+
+			print_tab(header);
+			fwprintf(header.file, L"struct MessageTraits<MsgType::%s>\n", info.name);
+
+			print_tab(header);
+			fwprintf(header.file, L"{\n");
+
+			++header.tab_cnt;
+
+			print_tab(header);
+			fwprintf(header.file, L"static constexpr const char* NAME = \"%s\";\n", info.name);
+
+			print_tab(header);
+			fwprintf(header.file, L"static constexpr MsgType TYPE = MsgType::%s;\n", info.name);
+
+			print_tab(header);
+			fwprintf(header.file, L"static constexpr Direction DIRECTION = Direction::%s;\n", info.name[0] == L'S' ? L"SC" : L"CS");
+
+			print_tab(header);
+			fwprintf(header.file, L"static constexpr size_t PAYLOAD_SIZE = %d;\n", info.min_size);
+
+			print_tab(header);
+			fwprintf(header.file, L"static constexpr size_t FRAME_SIZE = %d;\n\n", type_id.header_size + info.min_size + integrity.trailer_size);
+
+			print_tab(header);
+			fwprintf(header.file, L"using Fields = TypeList<");
+
+			for (int j = 0; j < info.param_cnt; ++j)
+			{
+				fwprintf(header.file, j == 0 ? L"%s" : L", %s", info.param_type[j]);
+			}
+
+			fwprintf(header.file, L">;\n");
+
+			--header.tab_cnt;
+
+			print_tab(header);
+			fwprintf(header.file, L"};\n");
+		}
+
+		// dense tables in protocol.txt order, message_index() maps a type onto them
+		fwprintf(header.file, L"\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"constexpr size_t MESSAGE_CNT = %d;\n", protocol_cnt);
+
+		const wchar_t* const table_type[] = { L"MsgType", L"const char*", L"Direction", L"size_t" };
+		const wchar_t* const table_name[] = { L"TYPES", L"NAMES", L"DIRECTIONS", L"PAYLOAD_SIZES" };
+
+		for (int t = 0; t < 4; ++t)
+		{
+			fwprintf(header.file, L"\n");
+
+			print_tab(header);
+			fwprintf(header.file, L"constexpr %s MESSAGE_%s[MESSAGE_CNT] =\n", table_type[t], table_name[t]);
+
+			print_tab(header);
+			fwprintf(header.file, L"{\n");
+
+			for (int i = 0; i < protocol_cnt; ++i)
+			{
+				print_tab(header);
+				fwprintf(header.file, L"\tMessageTraits<MsgType::%s>::%s,\n", protocols[i].name,
+					t == 0 ? L"TYPE" : t == 1 ? L"NAME" : t == 2 ? L"DIRECTION" : L"PAYLOAD_SIZE");
+			}
+
+			print_tab(header);
+			fwprintf(header.file, L"};\n");
+		}
+
+		fwprintf(header.file, L"\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"// MESSAGE_CNT for a type that is not in protocol.txt\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"constexpr size_t message_index(MsgType type)\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"{\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"\tswitch (type)\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"\t{\n");
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			print_tab(header);
+			fwprintf(header.file, L"\tcase MsgType::%s:\n", protocols[i].name);
+
+			print_tab(header);
+			fwprintf(header.file, L"\t\treturn %d;\n", i);
+		}
+
+		print_tab(header);
+		fwprintf(header.file, L"\tdefault:\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"\t\treturn MESSAGE_CNT;\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"\t}\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"}\n");
+
+		print_shared_close(header);
+	}
+
+	void print_rate(FileInfo& header)
+	{
+		static const wchar_t* const clock[] =
+		{
+			L"// milliseconds from a coarse monotonic clock, its jitter only shifts when a bucket refills",
+			L"inline uint32_t rate_tick_ms()",
+			L"{",
+			L"#ifdef _WIN32",
+			L"\treturn static_cast<uint32_t>(GetTickCount64());",
+			L"#else",
+			L"\ttimespec now;",
+			L"\tclock_gettime(CLOCK_MONOTONIC_COARSE, &now);",
+			L"",
+			L"\treturn static_cast<uint32_t>(now.tv_sec * 1000 + now.tv_nsec / 1000000);",
+			L"#endif",
+			L"}",
+			L"",
+			L"struct RateLimitEntry",
+			L"{",
+			L"\tuint32_t per_second;",
+			L"\tuint32_t burst;",
+			L"};",
+		};
+
+		static const wchar_t* const limiter[] =
+		{
+			L"// one token bucket per limited message, refilled lazily when that message arrives",
+			L"// tokens are counted in thousandths, so a millisecond tick refills per_second of them exactly",
+			L"class RateLimiter",
+			L"{",
+			L"public:",
+			L"\tRateLimiter()",
+			L"\t{",
+			L"\t\treset();",
+			L"\t}",
+			L"",
+			L"\t// spends a token of slot, false when its bucket is empty",
+			L"\tbool admit(int slot, uint32_t now)",
+			L"\t{",
+			L"\t\tBucket& bucket = buckets_[slot];",
+			L"\t\tconst RateLimitEntry& limit = RATE_LIMIT[slot];",
+			L"",
+			L"\t\tuint32_t elapsed = now - bucket.tick;",
+			L"",
+			L"\t\tif (elapsed != 0)",
+			L"\t\t{",
+			L"\t\t\tuint64_t tokens = bucket.tokens + static_cast<uint64_t>(elapsed) * limit.per_second;",
+			L"\t\t\tuint32_t capacity = limit.burst * 1000;",
+			L"",
+			L"\t\t\tbucket.tokens = tokens < capacity ? static_cast<uint32_t>(tokens) : capacity;",
+			L"\t\t\tbucket.tick = now;",
+			L"\t\t}",
+			L"",
+			L"\t\tif (bucket.tokens < 1000)",
+			L"\t\t{",
+			L"\t\t\t++rejected_;",
+			L"\t\t\treturn false;",
+			L"\t\t}",
+			L"",
+			L"\t\tbucket.tokens -= 1000;",
+			L"\t\treturn true;",
+			L"\t}",
+			L"",
+			L"\t// frames refused since the last reset, a session policy may kick on it",
+			L"\tuint64_t rejected() const",
+			L"\t{",
+			L"\t\treturn rejected_;",
+			L"\t}",
+			L"",
+			L"\t// full buckets, call when the session is reused for a new connection",
+			L"\tvoid reset()",
+			L"\t{",
+			L"\t\tuint32_t now = rate_tick_ms();",
+			L"",
+			L"\t\tfor (int i = 0; i < RATE_SLOT_CNT; ++i)",
+			L"\t\t{",
+			L"\t\t\tbuckets_[i].tokens = RATE_LIMIT[i].burst * 1000;",
+			L"\t\t\tbuckets_[i].tick = now;",
+			L"\t\t}",
+			L"",
+			L"\t\trejected_ = 0;",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tstruct Bucket",
+			L"\t{",
+			L"\t\tuint32_t tokens;",
+			L"\t\tuint32_t tick;",
+			L"\t};",
+			L"",
+			L"\tBucket buckets_[RATE_SLOT_CNT > 0 ? RATE_SLOT_CNT : 1];",
+			L"\tuint64_t rejected_;",
+			L"};",
+		};
+
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, L"#ifdef _WIN32\n#define WIN32_LEAN_AND_MEAN\n#include <Windows.h>\n#else\n#include <time.h>\n#endif\n\n#include <cstdint>\n\n");
+
+		print_shared_namespace(header);
+
+		print_lines(header, clock, sizeof(clock) / sizeof(clock[0]));
+
+		// dense slots in protocol.txt order, the stubs map a type onto its slot through RATE_SLOT
+		fwprintf(header.file, L"\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"constexpr int RATE_SLOT_CNT = %d;\n\n", rate_slot_cnt);
+
+		print_tab(header);
+		fwprintf(header.file, L"constexpr RateLimitEntry RATE_LIMIT[RATE_SLOT_CNT > 0 ? RATE_SLOT_CNT : 1] =\n");
+
+		print_tab(header);
+		fwprintf(header.file, L"{\n");
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			if (protocols[i].rate_slot == -1)
+			{
+				continue;
+			}
+
+			print_tab(header);
+			fwprintf(header.file, L"\t{ %d, %d }, // %s\n", protocols[i].rate, protocols[i].burst, protocols[i].name);
+		}
+
+		print_tab(header);
+		fwprintf(header.file, L"};\n\n");
+
+		print_lines(header, limiter, sizeof(limiter) / sizeof(limiter[0]));
+
+		print_shared_close(header);
+	}
+
+	void print_trace(FileInfo& header)
+	{
+		static const wchar_t* const head[] =
+		{
+			L"enum class TracePoint : unsigned char",
+			L"{",
+			L"\tDISPATCH_ENTER,",
+			L"\tDISPATCH_EXIT,",
+			L"\tENCODE,",
+			L"};",
+			L"",
+			L"// type, then payload bytes and the session for dispatch, frame bytes and the frame for encode",
+			L"using TraceHook = void (*)(TracePoint point, int type, int size, const void* context);",
+			L"",
+			L"// the one in-process consumer of hook builds, nullptr detaches it",
+			L"inline std::atomic<TraceHook> trace_hook{ nullptr };",
+			L"",
+			L"// enter fires now and exit when dispatch returns, whichever return that is",
+			L"class DispatchTrace",
+			L"{",
+			L"public:",
+			L"\tDispatchTrace(int type, int size, const void* session) : type_(type), size_(size), session_(session)",
+			L"\t{",
+		};
+
+		static const wchar_t* const mid[] =
+		{
+			L"\t}",
+			L"",
+			L"\t~DispatchTrace()",
+			L"\t{",
+		};
+
+		static const wchar_t* const tail[] =
+		{
+			L"\t}",
+			L"",
+			L"\tDispatchTrace(const DispatchTrace&) = delete;",
+			L"\tDispatchTrace& operator=(const DispatchTrace&) = delete;",
+			L"",
+			L"private:",
+			L"\tint type_;",
+			L"\tint size_;",
+			L"\tconst void* session_;",
+			L"};",
+		};
+
+		// the macros expand in any namespace, so they name the types from the global scope
+		wchar_t scope[BUFFER_SIZE] = L"::";
+
+		if (ns.enable)
+		{
+			wcscat_s(scope, BUFFER_SIZE, ns.global);
+			wcscat_s(scope, BUFFER_SIZE, L"::");
+		}
+
+		fwprintf(header.file, L"#pragma once\n\n#include <atomic>\n\n");
+		fwprintf(header.file, L"// %s_TRACE_USDT: sys/sdt.h probes %s:dispatch_enter, %s:dispatch_exit and %s:encode, each behind a semaphore\n", trace.prefix, trace.provider, trace.provider, trace.provider);
+		fwprintf(header.file, L"// %s_TRACE_HOOK: every tracepoint calls the TraceHook stored in trace_hook\n", trace.prefix);
+		fwprintf(header.file, L"// neither: the tracepoints compile to nothing\n");
+		fwprintf(header.file, L"#if defined(%s_TRACE_USDT)\n", trace.prefix);
+		fwprintf(header.file, L"#define _SDT_HAS_SEMAPHORES 1\n#include <sys/sdt.h>\n\n// perf and bpftrace raise a semaphore while attached, so a detached probe is one load and a not-taken branch\nextern \"C\"\n{\n");
+		fwprintf(header.file, L"\t__attribute__((weak, section(\".probes\"))) volatile unsigned short %s_dispatch_enter_semaphore;\n", trace.provider);
+		fwprintf(header.file, L"\t__attribute__((weak, section(\".probes\"))) volatile unsigned short %s_dispatch_exit_semaphore;\n", trace.provider);
+		fwprintf(header.file, L"\t__attribute__((weak, section(\".probes\"))) volatile unsigned short %s_encode_semaphore;\n", trace.provider);
+		fwprintf(header.file, L"}\n\n");
+		fwprintf(header.file, L"#define %s_TRACE_POINT(probe, point, type, size, context) \\\n", trace.prefix);
+		fwprintf(header.file, L"\tdo { if (__builtin_expect(%s_##probe##_semaphore != 0, 0)) STAP_PROBE3(%s, probe, type, size, context); } while (0)\n", trace.provider, trace.provider);
+		fwprintf(header.file, L"#elif defined(%s_TRACE_HOOK)\n", trace.prefix);
+		fwprintf(header.file, L"#define %s_TRACE_POINT(probe, point, type, size, context) \\\n", trace.prefix);
+		fwprintf(header.file, L"\tdo { if (%sTraceHook hook_ = %strace_hook.load(std::memory_order_relaxed)) hook_(%sTracePoint::point, type, size, context); } while (0)\n", scope, scope, scope);
+		fwprintf(header.file, L"#else\n");
+		fwprintf(header.file, L"#define %s_TRACE_POINT(probe, point, type, size, context) static_cast<void>(0)\n", trace.prefix);
+		fwprintf(header.file, L"#endif\n\n");
+		fwprintf(header.file, L"#if defined(%s_TRACE_USDT) || defined(%s_TRACE_HOOK)\n", trace.prefix, trace.prefix);
+		fwprintf(header.file, L"#define %s_TRACE_DISPATCH(type, size, session) %sDispatchTrace dispatch_trace_(static_cast<int>(type), static_cast<int>(size), session)\n", trace.prefix, scope);
+		fwprintf(header.file, L"#define %s_TRACE_ENCODE(type, size, frame) %s_TRACE_POINT(encode, ENCODE, static_cast<int>(type), static_cast<int>(size), static_cast<const void*>(frame))\n", trace.prefix, trace.prefix);
+		fwprintf(header.file, L"#else\n");
+		fwprintf(header.file, L"#define %s_TRACE_DISPATCH(type, size, session) static_cast<void>(0)\n", trace.prefix);
+		fwprintf(header.file, L"#define %s_TRACE_ENCODE(type, size, frame) static_cast<void>(0)\n", trace.prefix);
+		fwprintf(header.file, L"#endif\n\n");
+
+		print_shared_namespace(header);
+
+		print_lines(header, head, sizeof(head) / sizeof(head[0]));
+
+		print_tab(header);
+		fwprintf(header.file, L"\t\t%s_TRACE_POINT(dispatch_enter, DISPATCH_ENTER, type_, size_, session_);\n", trace.prefix);
+
+		print_lines(header, mid, sizeof(mid) / sizeof(mid[0]));
+
+		print_tab(header);
+		fwprintf(header.file, L"\t\t%s_TRACE_POINT(dispatch_exit, DISPATCH_EXIT, type_, size_, session_);\n", trace.prefix);
+
+		print_lines(header, tail, sizeof(tail) / sizeof(tail[0]));
+
+		print_shared_close(header);
+	}
+
+	void print_trace_encode(FileInfo& body, const wchar_t* frame, const wchar_t* size_name, int size)
+	{
+		print_tab(body);
+		if (shape_body)
+		{
+			fwprintf(body.file, L"%s_TRACE_ENCODE(type, ", trace.prefix);
+		}
+		else
+		{
+			fwprintf(body.file, L"%s_TRACE_ENCODE(%d, ", trace.prefix, protocol.protocol_type);
+		}
+
+		if (size_name == nullptr)
+		{
+			fwprintf(body.file, L"%d", size);
+		}
+		else if (size == 0)
+		{
+			fwprintf(body.file, L"%s", size_name);
+		}
+		else
+		{
+			fwprintf(body.file, L"%s + %d", size_name, size);
+		}
+
+		fwprintf(body.file, L", %s);\n", frame);
+	}
+
+	void print_bot(FileInfo& cpp)
+	{
+		static const wchar_t* const head[] =
+		{
+			L"// load generator: simulated clients on one epoll loop send a weighted CS_ mix and time the probe replies",
+			L"inline unsigned long long bot_clock_us()",
+			L"{",
+			L"\treturn static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::microseconds>(",
+			L"\t\tstd::chrono::steady_clock::now().time_since_epoch()).count());",
+			L"}",
+			L"",
+			L"struct BotStats",
+			L"{",
+			L"\tunsigned long long sent_frames = 0;",
+			L"\tunsigned long long sent_bytes = 0;",
+			L"\tunsigned long long recv_frames = 0;",
+			L"\tunsigned long long recv_bytes = 0;",
+			L"\tstd::vector<unsigned int> latency_us;",
+			L"};",
+		};
+
+		static const wchar_t* const body[] =
+		{
+			L"struct BotConnection",
+			L"{",
+			L"\tBotConnection(Bot& bot, int socket, unsigned int seed) : fd(socket), reader(bot, nullptr), rng(seed)",
+			L"\t{",
+			L"\t}",
+			L"",
+			L"\t// false once the socket failed, bytes the kernel did not take wait for the next tick",
+			L"\tbool flush()",
+			L"\t{",
+			L"\t\twhile (head < pending.size())",
+			L"\t\t{",
+			L"\t\t\tssize_t sent = send(fd, pending.data() + head, pending.size() - head, MSG_NOSIGNAL);",
+			L"",
+			L"\t\t\tif (sent < 0)",
+			L"\t\t\t{",
+			L"\t\t\t\treturn errno == EAGAIN || errno == EWOULDBLOCK;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\thead += static_cast<size_t>(sent);",
+			L"\t\t}",
+			L"",
+			L"\t\tpending.clear();",
+			L"\t\thead = 0;",
+			L"",
+			L"\t\treturn true;",
+			L"\t}",
+			L"",
+			L"\tbool receive(BotStats& stats)",
+			L"\t{",
+			L"\t\tchar buffer[65536];",
+			L"",
+			L"\t\tfor (;;)",
+			L"\t\t{",
+			L"\t\t\tssize_t received = recv(fd, buffer, sizeof(buffer), 0);",
+			L"",
+			L"\t\t\tif (received < 0)",
+			L"\t\t\t{",
+			L"\t\t\t\treturn errno == EAGAIN || errno == EWOULDBLOCK;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tif (received == 0 || !reader.feed(buffer, static_cast<size_t>(received)))",
+			L"\t\t\t{",
+			L"\t\t\t\treturn false;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tstats.recv_bytes += static_cast<unsigned long long>(received);",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tint fd;",
+			L"\tBotReader reader;",
+			L"\tstd::mt19937 rng;",
+			L"\tstd::vector<char> pending;",
+			L"\tsize_t head = 0;",
+			L"\tunsigned long long sent_frames = 0;",
+			L"};",
+			L"",
+			L"// samples must be sorted",
+			L"inline unsigned int percentile(const std::vector<unsigned int>& samples, double rank)",
+			L"{",
+			L"\tif (samples.empty())",
+			L"\t{",
+			L"\t\treturn 0;",
+			L"\t}",
+			L"",
+			L"\treturn samples[static_cast<size_t>(rank * static_cast<double>(samples.size() - 1) + 0.5)];",
+			L"}",
+			L"",
+			L"// every client sends rate messages per second for seconds, then the report goes to stdout",
+			L"inline int run_bots(const char* host, unsigned short port, int clients, int seconds, int rate)",
+			L"{",
+			L"\tsockaddr_in address = {};",
+			L"\taddress.sin_family = AF_INET;",
+			L"\taddress.sin_port = htons(port);",
+			L"",
+			L"\tif (inet_pton(AF_INET, host, &address.sin_addr) != 1)",
+			L"\t{",
+			L"\t\tfprintf(stderr, \"bad address %s\\n\", host);",
+			L"\t\treturn 1;",
+			L"\t}",
+			L"",
+			L"\tint epoll_fd = epoll_create1(0);",
+			L"",
+			L"\tif (epoll_fd < 0)",
+			L"\t{",
+			L"\t\tperror(\"epoll_create1\");",
+			L"\t\treturn 1;",
+			L"\t}",
+			L"",
+			L"\tBotStats stats;",
+			L"\tBot bot(stats);",
+			L"\tstd::vector<std::unique_ptr<BotConnection>> connections;",
+			L"",
+			L"\tfor (int i = 0; i < clients; ++i)",
+			L"\t{",
+			L"\t\tint fd = socket(AF_INET, SOCK_STREAM, 0);",
+			L"",
+			L"\t\tif (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)",
+			L"\t\t{",
+			L"\t\t\tperror(\"connect\");",
+			L"",
+			L"\t\t\tif (fd >= 0)",
+			L"\t\t\t{",
+			L"\t\t\t\tclose(fd);",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tbreak;",
+			L"\t\t}",
+			L"",
+			L"\t\tint one = 1;",
+			L"\t\tsetsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));",
+			L"\t\tfcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);",
+			L"",
+			L"\t\tconnections.push_back(std::make_unique<BotConnection>(bot, fd, static_cast<unsigned int>(i)));",
+			L"",
+			L"\t\tepoll_event event = {};",
+			L"\t\tevent.events = EPOLLIN;",
+			L"\t\tevent.data.ptr = connections.back().get();",
+			L"\t\tepoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);",
+			L"\t}",
+			L"",
+			L"\tif (connections.empty())",
+			L"\t{",
+			L"\t\tclose(epoll_fd);",
+			L"\t\treturn 1;",
+			L"\t}",
+			L"",
+			L"\tsize_t alive = connections.size();",
+			L"\tprintf(\"%zu clients connected\\n\", alive);",
+			L"",
+			L"\tauto drop = [&](BotConnection& connection)",
+			L"\t{",
+			L"\t\tepoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection.fd, nullptr);",
+			L"\t\tclose(connection.fd);",
+			L"\t\tconnection.fd = -1;",
+			L"\t\t--alive;",
+			L"\t};",
+			L"",
+			L"\tSerializeBuffer msg;",
+			L"\tepoll_event events[256];",
+			L"",
+			L"\tunsigned long long start = bot_clock_us();",
+			L"\tunsigned long long now = start;",
+			L"\tunsigned long long stop = start + static_cast<unsigned long long>(seconds) * 1000000;",
+			L"",
+			L"\twhile (alive > 0 && now < stop)",
+			L"\t{",
+			L"\t\t// clients are topped up to rate * elapsed messages, so a slow tick catches up on the next one",
+			L"\t\tunsigned long long due = (now - start) * static_cast<unsigned long long>(rate) / 1000000;",
+			L"",
+			L"\t\tfor (auto& connection : connections)",
+			L"\t\t{",
+			L"\t\t\tif (connection->fd < 0)",
+			L"\t\t\t{",
+			L"\t\t\t\tcontinue;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tfor (; connection->sent_frames < due; ++connection->sent_frames)",
+			L"\t\t\t{",
+			L"\t\t\t\tencode_random(connection->rng, &msg);",
+			L"",
+			L"\t\t\t\tconst char* frame = reinterpret_cast<const char*>(msg.read_pos());",
+			L"\t\t\t\tconnection->pending.insert(connection->pending.end(), frame, frame + msg.size());",
+			L"",
+			L"\t\t\t\t++stats.sent_frames;",
+			L"\t\t\t\tstats.sent_bytes += static_cast<unsigned long long>(msg.size());",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tif (!connection->flush())",
+			L"\t\t\t{",
+			L"\t\t\t\tdrop(*connection);",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\tint ready = epoll_wait(epoll_fd, events, 256, 1);",
+			L"",
+			L"\t\tfor (int i = 0; i < ready; ++i)",
+			L"\t\t{",
+			L"\t\t\tBotConnection* connection = static_cast<BotConnection*>(events[i].data.ptr);",
+			L"",
+			L"\t\t\tif (connection->fd >= 0 && !connection->receive(stats))",
+			L"\t\t\t{",
+			L"\t\t\t\tdrop(*connection);",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\tnow = bot_clock_us();",
+			L"\t}",
+			L"",
+			L"\tdouble elapsed = static_cast<double>(now - start) / 1e6;",
+			L"",
+			L"\tprintf(\"%.1f s, %zu of %zu clients still connected\\n\", elapsed, alive, connections.size());",
+			L"\tprintf(\"sent     %llu frames, %.0f frames/s, %.2f MB/s\\n\",",
+			L"\t\tstats.sent_frames, static_cast<double>(stats.sent_frames) / elapsed, static_cast<double>(stats.sent_bytes) / elapsed / 1e6);",
+			L"\tprintf(\"received %llu frames, %.0f frames/s, %.2f MB/s\\n\",",
+			L"\t\tstats.recv_frames, static_cast<double>(stats.recv_frames) / elapsed, static_cast<double>(stats.recv_bytes) / elapsed / 1e6);",
+			L"",
+			L"\tstd::sort(stats.latency_us.begin(), stats.latency_us.end());",
+			L"",
+			L"\tprintf(\"round trip us: p50 %u, p90 %u, p99 %u, p99.9 %u, max %u (%zu samples)\\n\",",
+			L"\t\tpercentile(stats.latency_us, 0.5), percentile(stats.latency_us, 0.9), percentile(stats.latency_us, 0.99),",
+			L"\t\tpercentile(stats.latency_us, 0.999), percentile(stats.latency_us, 1.0), stats.latency_us.size());",
+			L"",
+			L"\tfor (auto& connection : connections)",
+			L"\t{",
+			L"\t\tif (connection->fd >= 0)",
+			L"\t\t{",
+			L"\t\t\tclose(connection->fd);",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tclose(epoll_fd);",
+			L"",
+			L"\treturn 0;",
+			L"}",
+		};
+
+		int request = -1;
+		int reply = -1;
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			if (wcscmp(protocols[i].name, bot.request) == 0 && !is_stub_of(protocols[i], CLIENT) && protocols[i].param_cnt > 0 && protocols[i].param_length[0] == 0)
+			{
+				request = i;
+			}
+
+			if (wcscmp(protocols[i].name, bot.reply) == 0 && is_stub_of(protocols[i], CLIENT) && protocols[i].param_cnt > 0 && protocols[i].param_length[0] == 0)
+			{
+				reply = i;
+			}
+		}
+
+		// without a probe pair the harness still drives load, it just reports no round trips
+		if (request == -1 || reply == -1)
+		{
+			wprintf(L"bot.request/bot.reply must name a CS_ and an SC_ message with a timestamp parameter, latency is not measured\n");
+			request = -1;
+			reply = -1;
+		}
+
+		fwprintf(cpp.file, L"#if defined(__linux__)\n\n");
+
+		fwprintf(cpp.file, L"#include \"%s\"\n", cph.filename);
+		fwprintf(cpp.file, L"#include \"%s\"\n", csh.filename);
+		fwprintf(cpp.file, L"#include \"%s\"\n", stm.filename);
+		fwprintf(cpp.file, L"#include \"%s\"\n\n", serial_buffer.header);
+
+		fwprintf(cpp.file, L"#include <arpa/inet.h>\n#include <fcntl.h>\n#include <netinet/in.h>\n#include <netinet/tcp.h>\n");
+		fwprintf(cpp.file, L"#include <sys/epoll.h>\n#include <sys/socket.h>\n#include <unistd.h>\n\n");
+		fwprintf(cpp.file, L"#include <algorithm>\n#include <cerrno>\n#include <chrono>\n#include <cstdio>\n#include <cstdlib>\n#include <memory>\n#include <random>\n#include <vector>\n\n");
+
+		if (!ns.enable_side)
+		{
+			print_bot_hook(cpp);
+		}
+
+		print_shared_namespace(cpp);
+
+		print_lines(cpp, head, sizeof(head) / sizeof(head[0]));
+
+		fwprintf(cpp.file, L"\n");
+
+		if (ns.enable_side)
+		{
+			print_bot_hook(cpp);
+		}
+
+		print_bot_stub(cpp, reply);
+
+		fwprintf(cpp.file, L"\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"using BotReader = StreamDispatcher<Bot, %s%s>;\n\n", ns.enable_side ? L"client::" : L"", session.type);
+
+		print_bot_mix(cpp, request, L"bot_clock_us()", L"microseconds", ns.enable_side ? L"client::frame_guard(nullptr)" : L"::frame_guard(nullptr)");
+
+		fwprintf(cpp.file, L"\n");
+
+		print_lines(cpp, body, sizeof(body) / sizeof(body[0]));
+
+		if (ns.enable)
+		{
+			--cpp.tab_cnt;
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		fwprintf(cpp.file, L"\n// %.*s [host] [port] [clients] [seconds] [rate]\n",
+			static_cast<int>(wcslen(cpp.filename) - wcslen(EXTENSION[CPP])), cpp.filename);
+		fwprintf(cpp.file, L"int main(int argc, char** argv)\n");
+		fwprintf(cpp.file, L"{\n");
+		fwprintf(cpp.file, L"\tconst char* host = argc > 1 ? argv[1] : \"127.0.0.1\";\n");
+		fwprintf(cpp.file, L"\tint port = argc > 2 ? atoi(argv[2]) : %d;\n", bot.port);
+		fwprintf(cpp.file, L"\tint clients = argc > 3 ? atoi(argv[3]) : %d;\n", bot.clients);
+		fwprintf(cpp.file, L"\tint seconds = argc > 4 ? atoi(argv[4]) : %d;\n", bot.seconds);
+		fwprintf(cpp.file, L"\tint rate = argc > 5 ? atoi(argv[5]) : %d;\n\n", bot.rate);
+		fwprintf(cpp.file, L"\treturn %s%srun_bots(host, static_cast<unsigned short>(port), clients, seconds, rate);\n",
+			ns.enable ? ns.global : L"", ns.enable ? L"::" : L"");
+		fwprintf(cpp.file, L"}\n\n");
+
+		fwprintf(cpp.file, L"#endif");
+
+		fclose(cpp.file);
+		cpp.file = nullptr;
+	}
+
+	// the stream dispatcher finds these by ADL, so they go where the client session lives: client:: with side namespaces, else global scope
+	void print_bot_hook(FileInfo& cpp)
+	{
+		if (!integrity.enable && !ping.enable)
+		{
+			return;
+		}
+
+		const wchar_t* global = ns.enable && !ns.enable_side ? ns.global : L"";
+		const wchar_t* scope = ns.enable && !ns.enable_side ? L"::" : L"";
+
+		if (ns.enable_side)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"namespace client\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			++cpp.tab_cnt;
+		}
+
+		if (integrity.enable)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"// one unkeyed guard seals and checks every bot frame, keyed sessions are not simulated\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"inline %s%sFrameGuard& frame_guard(%s*)\n", global, scope, session.type);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tstatic %s%sFrameGuard guard;\n", global, scope);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn guard;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		if (ping.enable)
+		{
+			if (integrity.enable)
+			{
+				fwprintf(cpp.file, L"\n");
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"// pings from the server are measured into one shared PingStats, bots never answer them\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"inline %s%sPingStats& ping_stats(%s*)\n", global, scope, session.type);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tstatic %s%sPingStats stats;\n", global, scope);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn stats;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"inline bool ping_send(%s*, const char*, size_t)\n", session.type);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn true;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		if (ns.enable_side)
+		{
+			--cpp.tab_cnt;
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		fwprintf(cpp.file, L"\n");
+	}
+
+	void print_bot_stub(FileInfo& cpp, int reply)
+	{
+		const wchar_t* side = ns.enable_side ? L"client::" : L"";
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"// counts every server frame, the probe reply also records its round trip\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"class Bot : public %s%s\n", side, RPC_CLASS[STUB]);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"public:\n");
+
+		++cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"explicit Bot(BotStats& stats) : stats_(&stats)\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n");
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			const Protocol& info = protocols[i];
+
+			if (!is_stub_of(info, CLIENT))
+			{
+				continue;
+			}
+
+			fwprintf(cpp.file, L"\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"bool %s(%s%s*", info.lower_name, side, session.type);
+
+			if (view.enable)
+			{
+				fwprintf(cpp.file, i == reply ? L", %sView view" : L", %sView", info.class_name);
+			}
+			else
+			{
+				for (int j = 0; j < info.param_cnt; ++j)
+				{
+					fwprintf(cpp.file, i == reply && j == 0 ? L", %s %s" : L", %s", info.param_type[j], info.param_name[j]);
+				}
+			}
+
+			fwprintf(cpp.file, L") override\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			if (i == reply)
+			{
+				// the probe time went out truncated to the parameter, so the difference wraps the same way
+				print_tab(cpp);
+				fwprintf(cpp.file, L"\tunsigned long long sent = static_cast<unsigned long long>(%s%s%s);\n",
+					view.enable ? L"view." : L"", info.param_name[0], view.enable ? L"()" : L"");
+
+				print_tab(cpp);
+				if (info.param_size[0] < 4)
+				{
+					fwprintf(cpp.file, L"\tstats_->latency_us.push_back(static_cast<unsigned int>((bot_clock_us() - sent) & 0x%llXull));\n\n",
+						(1ull << (info.param_size[0] * 8)) - 1);
+				}
+				else
+				{
+					fwprintf(cpp.file, L"\tstats_->latency_us.push_back(static_cast<unsigned int>(bot_clock_us() - sent));\n\n");
+				}
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn received();\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		fwprintf(cpp.file, L"\n");
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"private:\n");
+
+		++cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"bool received()\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"\t++stats_->recv_frames;\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"\treturn true;\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"BotStats* stats_;\n");
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"};\n");
+	}
+
+	void print_bot_mix(FileInfo& cpp, int request, const wchar_t* clock, const wchar_t* unit, const wchar_t* guard)
+	{
+		int total = 0;
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			if (!is_stub_of(protocols[i], CLIENT))
+			{
+				total += protocols[i].weight;
+			}
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"// one message of the [weight = n] mix, the probe carries its send time in %s\n", unit);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"inline void encode_random(std::mt19937& rng, %s* %s)\n", serial_buffer.type, serial_buffer.param);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"%s%s proxy;\n", ns.enable_side ? L"client::" : L"", RPC_CLASS[PROXY]);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"unsigned int pick = static_cast<unsigned int>(rng() %% %d);\n", total > 0 ? total : 1);
+
+		int bound = 0;
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			const Protocol& info = protocols[i];
+
+			if (is_stub_of(info, CLIENT) || info.weight == 0)
+			{
+				continue;
+			}
+
+			bound += info.weight;
+
+			fwprintf(cpp.file, L"\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"if (pick < %d)\n", bound);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tproxy.mp_%s(%s", info.lower_name, serial_buffer.param);
+
+			if (integrity.enable && !outbox.enable)
+			{
+				fwprintf(cpp.file, L", &%s", guard);
+			}
+
+			for (int j = 0; j < info.param_cnt; ++j)
+			{
+				if (info.param_length[j] > 0)
+				{
+					fwprintf(cpp.file, info.param_size[j] == 2 ? L", %s(u\"bot\")" : L", %s(\"bot\")", info.param_type[j]);
+					continue;
+				}
+
+				fwprintf(cpp.file, L", static_cast<%s>(%s)", info.param_type[j], i == request && j == 0 ? clock : L"rng()");
+			}
+
+			fwprintf(cpp.file, L");\n");
+
+			if (integrity.enable && outbox.enable)
+			{
+				print_direct_seal(cpp, guard, serial_buffer.param, L"->");
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n");
+	}
+
+	void print_loopback(FileInfo& cpp)
+	{
+		static const wchar_t* const head[] =
+		{
+			L"// in-process benchmark: client proxies feed the server stub through an SPSC ring on its own thread, replies come back the same way",
+			L"inline unsigned long long loopback_clock_ns()",
+			L"{",
+			L"\treturn static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(",
+			L"\t\tstd::chrono::steady_clock::now().time_since_epoch()).count());",
+			L"}",
+			L"",
+			L"struct LoopbackStats",
+			L"{",
+			L"\tunsigned long long sent_frames = 0;",
+			L"\tunsigned long long sent_bytes = 0;",
+			L"\tunsigned long long recv_frames = 0;",
+			L"\tstd::vector<unsigned int> latency_ns;",
+			L"};",
+			L"",
+			L"// one producer and one consumer, frames go in whole and come out as a byte stream for StreamDispatcher::feed",
+			L"class SpscRing",
+			L"{",
+			L"public:",
+			L"\t// capacity is a power of two",
+			L"\texplicit SpscRing(size_t capacity) : data_(new char[capacity]), capacity_(capacity)",
+			L"\t{",
+			L"\t}",
+			L"",
+			L"\t~SpscRing()",
+			L"\t{",
+			L"\t\tdelete[] data_;",
+			L"\t}",
+			L"",
+			L"\tSpscRing(const SpscRing&) = delete;",
+			L"\tSpscRing& operator=(const SpscRing&) = delete;",
+			L"",
+			L"\t// producer side, false until the consumer has made room",
+			L"\tbool push(const char* frame, size_t len)",
+			L"\t{",
+			L"\t\tsize_t tail = tail_.load(std::memory_order_relaxed);",
+			L"",
+			L"\t\tif (tail + len - head_cache_ > capacity_)",
+			L"\t\t{",
+			L"\t\t\thead_cache_ = head_.load(std::memory_order_acquire);",
+			L"",
+			L"\t\t\tif (tail + len - head_cache_ > capacity_)",
+			L"\t\t\t{",
+			L"\t\t\t\treturn false;",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\tsize_t offset = tail & (capacity_ - 1);",
+			L"\t\tsize_t first = len < capacity_ - offset ? len : capacity_ - offset;",
+			L"",
+			L"\t\tmemcpy(data_ + offset, frame, first);",
+			L"\t\tmemcpy(data_, frame + first, len - first);",
+			L"",
+			L"\t\ttail_.store(tail + len, std::memory_order_release);",
+			L"",
+			L"\t\treturn true;",
+			L"\t}",
+			L"",
+			L"\t// consumer side, feeds every published byte to reader, false once it rejected a frame",
+			L"\ttemplate <typename Reader>",
+			L"\tbool drain(Reader& reader, size_t& drained)",
+			L"\t{",
+			L"\t\tsize_t head = head_.load(std::memory_order_relaxed);",
+			L"\t\tsize_t tail = tail_.load(std::memory_order_acquire);",
+			L"",
+			L"\t\tdrained = tail - head;",
+			L"",
+			L"\t\tif (drained == 0)",
+			L"\t\t{",
+			L"\t\t\treturn true;",
+			L"\t\t}",
+			L"",
+			L"\t\tsize_t offset = head & (capacity_ - 1);",
+			L"\t\tsize_t first = drained < capacity_ - offset ? drained : capacity_ - offset;",
+			L"",
+			L"\t\tbool fed = reader.feed(data_ + offset, first) && (first == drained || reader.feed(data_, drained - first));",
+			L"",
+			L"\t\thead_.store(tail, std::memory_order_release);",
+			L"",
+			L"\t\treturn fed;",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tchar* data_;",
+			L"\tsize_t capacity_;",
+			L"",
+			L"\talignas(64) std::atomic<size_t> head_{ 0 };",
+			L"\talignas(64) std::atomic<size_t> tail_{ 0 };",
+			L"\tsize_t head_cache_ = 0; // the producer's last look at head_, refreshed only when the ring seems full",
+			L"};",
+		};
+
+		static const wchar_t* const drive[] =
+		{
+			L"// samples must be sorted",
+			L"inline unsigned int percentile(const std::vector<unsigned int>& samples, double rank)",
+			L"{",
+			L"\tif (samples.empty())",
+			L"\t{",
+			L"\t\treturn 0;",
+			L"\t}",
+			L"",
+			L"\treturn samples[static_cast<size_t>(rank * static_cast<double>(samples.size() - 1) + 0.5)];",
+			L"}",
+			L"",
+			L"// messages of the [weight = n] mix go through both rings, then the report goes to stdout",
+			L"inline int run_loopback(unsigned long long messages, size_t ring_size)",
+			L"{",
+			L"\tif (ring_size < 1024 || (ring_size & (ring_size - 1)) != 0)",
+			L"\t{",
+			L"\t\tfprintf(stderr, \"ring size must be a power of two of at least 1024\\n\");",
+			L"\t\treturn 1;",
+			L"\t}",
+			L"",
+			L"\tSpscRing requests(ring_size);",
+			L"\tSpscRing replies(ring_size);",
+			L"",
+			L"\tLoopbackStats stats;",
+			L"\tserver::LoopbackServer server_stub(replies);",
+			L"\tclient::LoopbackClient client_stub(stats);",
+		};
+
+		static const wchar_t* const body[] =
+		{
+			L"\tstd::atomic<bool> sending{ true };",
+			L"\tstd::atomic<bool> serving{ true };",
+			L"\tstd::atomic<bool> broken{ false };",
+			L"",
+			L"\tstd::thread server_thread([&]",
+			L"\t{",
+			L"\t\tfor (;;)",
+			L"\t\t{",
+			L"\t\t\t// read before draining, so an empty ring after the last push really is the end",
+			L"\t\t\tbool last = !sending.load(std::memory_order_acquire);",
+			L"\t\t\tsize_t drained = 0;",
+			L"",
+			L"\t\t\tif (!requests.drain(server_reader, drained))",
+			L"\t\t\t{",
+			L"\t\t\t\tbroken.store(true, std::memory_order_relaxed);",
+			L"\t\t\t\tbreak;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tif (drained == 0)",
+			L"\t\t\t{",
+			L"\t\t\t\tif (last)",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\tbreak;",
+			L"\t\t\t\t}",
+			L"",
+			L"\t\t\t\tstd::this_thread::yield();",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\tserving.store(false, std::memory_order_release);",
+			L"\t});",
+			L"",
+			L"\tSerializeBuffer msg;",
+			L"\tstd::mt19937 rng(1);",
+			L"",
+			L"\tauto receive = [&]",
+			L"\t{",
+			L"\t\tsize_t drained = 0;",
+			L"",
+			L"\t\tif (!replies.drain(client_reader, drained))",
+			L"\t\t{",
+			L"\t\t\tbroken.store(true, std::memory_order_relaxed);",
+			L"\t\t}",
+			L"\t};",
+			L"",
+			L"\tunsigned long long start = loopback_clock_ns();",
+			L"",
+			L"\tfor (unsigned long long i = 0; i < messages && !broken.load(std::memory_order_relaxed); ++i)",
+			L"\t{",
+			L"\t\tencode_random(rng, &msg);",
+			L"",
+			L"\t\tconst char* frame = reinterpret_cast<const char*>(msg.read_pos());",
+			L"\t\tsize_t size = static_cast<size_t>(msg.size());",
+			L"",
+			L"\t\tbool pushed = requests.push(frame, size);",
+			L"",
+			L"\t\t// replies are taken while waiting, a server blocked on a full reply ring would never free this one",
+			L"\t\twhile (!pushed && !broken.load(std::memory_order_relaxed))",
+			L"\t\t{",
+			L"\t\t\treceive();",
+			L"\t\t\tpushed = requests.push(frame, size);",
+			L"\t\t}",
+			L"",
+			L"\t\tif (!pushed)",
+			L"\t\t{",
+			L"\t\t\tbreak;",
+			L"\t\t}",
+			L"",
+			L"\t\t++stats.sent_frames;",
+			L"\t\tstats.sent_bytes += size;",
+			L"",
+			L"\t\treceive();",
+			L"\t}",
+			L"",
+			L"\tsending.store(false, std::memory_order_release);",
+			L"",
+			L"\twhile (serving.load(std::memory_order_acquire))",
+			L"\t{",
+			L"\t\treceive();",
+			L"\t}",
+			L"",
+			L"\tserver_thread.join();",
+			L"\treceive();",
+			L"",
+			L"\tdouble elapsed = static_cast<double>(loopback_clock_ns() - start) / 1e9;",
+			L"",
+			L"\tprintf(\"%.3f s, %zu byte rings\\n\", elapsed, ring_size);",
+			L"\tprintf(\"sent     %llu frames, %.0f frames/s, %.2f MB/s, %.1f ns per frame\\n\", stats.sent_frames,",
+			L"\t\tstatic_cast<double>(stats.sent_frames) / elapsed, static_cast<double>(stats.sent_bytes) / elapsed / 1e6,",
+			L"\t\tstats.sent_frames > 0 ? elapsed * 1e9 / static_cast<double>(stats.sent_frames) : 0.0);",
+			L"\tprintf(\"served   %llu frames on the server thread\\n\", server_stub.frames());",
+			L"\tprintf(\"received %llu frames back\\n\", stats.recv_frames);",
+			L"",
+			L"\tstd::sort(stats.latency_ns.begin(), stats.latency_ns.end());",
+			L"",
+			L"\tprintf(\"round trip ns, queued behind a full ring: p50 %u, p90 %u, p99 %u, p99.9 %u, max %u (%zu samples)\\n\",",
+			L"\t\tpercentile(stats.latency_ns, 0.5), percentile(stats.latency_ns, 0.9), percentile(stats.latency_ns, 0.99),",
+			L"\t\tpercentile(stats.latency_ns, 0.999), percentile(stats.latency_ns, 1.0), stats.latency_ns.size());",
+			L"",
+			L"\tif (broken.load())",
+			L"\t{",
+			L"\t\tfprintf(stderr, \"a frame was rejected, the run stopped early\\n\");",
+			L"\t\treturn 1;",
+			L"\t}",
+			L"",
+			L"\treturn 0;",
+			L"}",
+		};
+
+		int request = -1;
+		int reply = -1;
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			if (wcscmp(protocols[i].name, loopback.request) == 0 && !is_stub_of(protocols[i], CLIENT) && protocols[i].param_cnt > 0 && protocols[i].param_length[0] == 0)
+			{
+				request = i;
+			}
+
+			if (wcscmp(protocols[i].name, loopback.reply) == 0 && is_stub_of(protocols[i], CLIENT) && protocols[i].param_cnt > 0 && protocols[i].param_length[0] == 0)
+			{
+				reply = i;
+			}
+		}
+
+		// without a probe pair the rings still carry the mix, only round trips go unmeasured
+		if (request == -1 || reply == -1)
+		{
+			wprintf(L"loopback.request/loopback.reply must name a CS_ and an SC_ message with a timestamp parameter, latency is not measured\n");
+			request = -1;
+			reply = -1;
+		}
+
+		fwprintf(cpp.file, L"#include \"%s\"\n", cph.filename);
+		fwprintf(cpp.file, L"#include \"%s\"\n", csh.filename);
+		fwprintf(cpp.file, L"#include \"%s\"\n", sph.filename);
+		fwprintf(cpp.file, L"#include \"%s\"\n", ssh.filename);
+		fwprintf(cpp.file, L"#include \"%s\"\n", stm.filename);
+		fwprintf(cpp.file, L"#include \"%s\"\n\n", serial_buffer.header);
+
+		fwprintf(cpp.file, L"#include <algorithm>\n#include <atomic>\n#include <chrono>\n#include <cstdio>\n#include <cstdlib>\n#include <cstring>\n");
+		fwprintf(cpp.file, L"#include <random>\n#include <thread>\n#include <vector>\n\n");
+
+		print_shared_namespace(cpp);
+
+		print_lines(cpp, head, sizeof(head) / sizeof(head[0]));
+
+		for (int s_c = 0; s_c < 2; ++s_c)
+		{
+			fwprintf(cpp.file, L"\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"namespace %s\n", RPC_SIDE[s_c]);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			++cpp.tab_cnt;
+
+			print_loopback_hook(cpp);
+			print_loopback_stub(cpp, s_c, request, reply);
+
+			--cpp.tab_cnt;
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		fwprintf(cpp.file, L"\n");
+
+		print_bot_mix(cpp, request, L"loopback_clock_ns()", L"nanoseconds", L"client::frame_guard(nullptr)");
+
+		fwprintf(cpp.file, L"\n");
+
+		print_lines(cpp, drive, sizeof(drive) / sizeof(drive[0]));
+
+		fwprintf(cpp.file, L"\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"\tStreamDispatcher<server::LoopbackServer, server::%s> server_reader(server_stub, nullptr);\n", session.type);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"\tStreamDispatcher<client::LoopbackClient, client::%s> client_reader(client_stub, nullptr);\n\n", session.type);
+
+		print_lines(cpp, body, sizeof(body) / sizeof(body[0]));
+
+		if (ns.enable)
+		{
+			--cpp.tab_cnt;
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		fwprintf(cpp.file, L"\n// %.*s [messages] [ring bytes]\n",
+			static_cast<int>(wcslen(cpp.filename) - wcslen(EXTENSION[CPP])), cpp.filename);
+		fwprintf(cpp.file, L"int main(int argc, char** argv)\n");
+		fwprintf(cpp.file, L"{\n");
+		fwprintf(cpp.file, L"\tunsigned long long messages = argc > 1 ? strtoull(argv[1], nullptr, 10) : %d;\n", loopback.messages);
+		fwprintf(cpp.file, L"\tsize_t ring_size = argc > 2 ? static_cast<size_t>(strtoull(argv[2], nullptr, 10)) : %d;\n\n", loopback.ring);
+		fwprintf(cpp.file, L"\treturn %s%srun_loopback(messages, ring_size);\n", ns.enable ? ns.global : L"", ns.enable ? L"::" : L"");
+		fwprintf(cpp.file, L"}");
+
+		fclose(cpp.file);
+		cpp.file = nullptr;
+	}
+
+	// what the stream dispatcher and the stubs look up per session, one shared instance per side
+	void print_loopback_hook(FileInfo& cpp)
+	{
+		if (integrity.enable)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"// one unkeyed guard seals and checks every frame of this side\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"inline FrameGuard& frame_guard(%s*)\n", session.type);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tstatic FrameGuard guard;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn guard;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+		}
+
+		if (ping.enable)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"// nothing in the loopback pings, frames that do arrive are measured and left unanswered\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"inline PingStats& ping_stats(%s*)\n", session.type);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tstatic PingStats stats;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn stats;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"inline bool ping_send(%s*, const char*, size_t)\n", session.type);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn true;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+		}
+
+		if (rate_limit.enable)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"// all traffic shares one bucket set, so the mix is throttled like a single flooding session\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"RateLimiter& rate_limit(%s*)\n", session.type);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tstatic RateLimiter limiter;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn limiter;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+		}
+	}
+
+	// the server stub answers the probe through its proxy into the reply ring, the client stub times the reply
+	void print_loopback_stub(FileInfo& cpp, int s_c, int request, int reply)
+	{
+		const wchar_t* name = s_c == SERVER ? L"LoopbackServer" : L"LoopbackClient";
+		int probe = s_c == SERVER ? request : reply;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, s_c == SERVER ? L"// dispatched on the server thread\n" : L"// dispatched on the client thread while it sends\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"class %s : public %s\n", name, RPC_CLASS[STUB]);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"public:\n");
+
+		++cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, s_c == SERVER ? L"explicit %s(SpscRing& replies) : replies_(&replies)\n" : L"explicit %s(LoopbackStats& stats) : stats_(&stats)\n", name);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n");
+
+		if (s_c == SERVER)
+		{
+			fwprintf(cpp.file, L"\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"unsigned long long frames() const\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn frames_;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			const Protocol& info = protocols[i];
+
+			if (!is_stub_of(info, s_c))
+			{
+				continue;
+			}
+
+			fwprintf(cpp.file, L"\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"bool %s(%s*", info.lower_name, session.type);
+
+			if (view.enable)
+			{
+				fwprintf(cpp.file, i == probe ? L", %sView view" : L", %sView", info.class_name);
+			}
+			else
+			{
+				for (int j = 0; j < info.param_cnt; ++j)
+				{
+					fwprintf(cpp.file, i == probe && j == 0 ? L", %s %s" : L", %s", info.param_type[j], info.param_name[j]);
+				}
+			}
+
+			fwprintf(cpp.file, L") override\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			if (i == probe && s_c == SERVER)
+			{
+				const Protocol& answer = protocols[reply];
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"\tproxy_.mp_%s(&msg_", answer.lower_name);
+
+				if (integrity.enable && !outbox.enable)
+				{
+					fwprintf(cpp.file, L", &frame_guard(nullptr)");
+				}
+
+				for (int j = 0; j < answer.param_cnt; ++j)
+				{
+					if (j == 0)
+					{
+						fwprintf(cpp.file, L", static_cast<%s>(%s%s%s)", answer.param_type[0],
+							view.enable ? L"view." : L"", info.param_name[0], view.enable ? L"()" : L"");
+					}
+					else if (answer.param_length[j] > 0)
+					{
+						fwprintf(cpp.file, L", %s()", answer.param_type[j]);
+					}
+					else
+					{
+						fwprintf(cpp.file, L", static_cast<%s>(0)", answer.param_type[j]);
+					}
+				}
+
+				fwprintf(cpp.file, L");\n");
+
+				if (integrity.enable && outbox.enable)
+				{
+					print_direct_seal(cpp, L"frame_guard(nullptr)", L"msg_", L".");
+				}
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"\treturn answer();\n");
+			}
+			else
+			{
+				if (i == probe)
+				{
+					// the probe time went out truncated to the parameter, so the difference wraps the same way
+					print_tab(cpp);
+					fwprintf(cpp.file, L"\tunsigned long long sent = static_cast<unsigned long long>(%s%s%s);\n",
+						view.enable ? L"view." : L"", info.param_name[0], view.enable ? L"()" : L"");
+
+					print_tab(cpp);
+					if (info.param_size[0] < 4)
+					{
+						fwprintf(cpp.file, L"\tstats_->latency_ns.push_back(static_cast<unsigned int>((loopback_clock_ns() - sent) & 0x%llXull));\n\n",
+							(1ull << (info.param_size[0] * 8)) - 1);
+					}
+					else
+					{
+						fwprintf(cpp.file, L"\tstats_->latency_ns.push_back(static_cast<unsigned int>(loopback_clock_ns() - sent));\n\n");
+					}
+				}
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"\treturn received();\n");
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		fwprintf(cpp.file, L"\n");
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"private:\n");
+
+		++cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"bool received()\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, s_c == SERVER ? L"\t++frames_;\n" : L"\t++stats_->recv_frames;\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"\treturn true;\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n\n");
+
+		if (s_c == SERVER)
+		{
+			// the client drains replies while it waits to send, so this spin always ends
+			print_tab(cpp);
+			fwprintf(cpp.file, L"bool answer()\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\twhile (!replies_->push(reinterpret_cast<const char*>(msg_.read_pos()), static_cast<size_t>(msg_.size())))\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t\tstd::this_thread::yield();\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t}\n\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn received();\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"SpscRing* replies_;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"%s proxy_;\n", RPC_CLASS[PROXY]);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"%s msg_;\n", serial_buffer.type);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"unsigned long long frames_ = 0;\n");
+		}
+		else
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"LoopbackStats* stats_;\n");
+		}
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"};\n");
+	}
+
+	void print_ping(FileInfo& header)
+	{
+		static const wchar_t* const head[] =
+		{
+			L"// steady clock, comparable across processes of one host, offsets between hosts come from PingStats",
+			L"inline uint64_t ping_clock_ns()",
+			L"{",
+			L"\treturn static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(",
+			L"\t\tstd::chrono::steady_clock::now().time_since_epoch()).count());",
+			L"}",
+			L"",
+			L"// per-session round trip and clock offset, updated by the receive path, read it from the same thread",
+			L"class PingStats",
+			L"{",
+			L"public:",
+			L"\tstatic constexpr int SUB_BUCKET_BITS = 3;",
+			L"\tstatic constexpr int BUCKET_CNT = (32 - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS; // microseconds up to 2^32",
+			L"\tstatic constexpr int OFFSET_WINDOW = 8;",
+			L"",
+			L"\tvoid on_pong(uint64_t sent_ns, uint64_t peer_ns, uint64_t now_ns)",
+			L"\t{",
+			L"\t\tint64_t rtt = static_cast<int64_t>(now_ns - sent_ns);",
+			L"",
+			L"\t\tif (rtt < 0)",
+			L"\t\t{",
+			L"\t\t\treturn;",
+			L"\t\t}",
+			L"",
+			L"\t\t// RFC 6298 smoothing: gain 1/8 for the mean, 1/4 for the deviation",
+			L"\t\tif (samples_ == 0)",
+			L"\t\t{",
+			L"\t\t\tsrtt_ns_ = rtt;",
+			L"\t\t\trttvar_ns_ = rtt / 2;",
+			L"\t\t\tmin_rtt_ns_ = rtt;",
+			L"\t\t}",
+			L"\t\telse",
+			L"\t\t{",
+			L"\t\t\tint64_t error = rtt - srtt_ns_;",
+			L"\t\t\tsrtt_ns_ += error / 8;",
+			L"\t\t\trttvar_ns_ += ((error < 0 ? -error : error) - rttvar_ns_) / 4;",
+			L"\t\t\tmin_rtt_ns_ = rtt < min_rtt_ns_ ? rtt : min_rtt_ns_;",
+			L"\t\t}",
+			L"",
+			L"\t\tlast_rtt_ns_ = rtt;",
+			L"",
+			L"\t\t// the peer stamped its clock about half a round trip after sent_ns",
+			L"\t\tSample& sample = window_[samples_ % OFFSET_WINDOW];",
+			L"\t\tsample.rtt_ns = rtt;",
+			L"\t\tsample.offset_ns = static_cast<int64_t>(peer_ns - sent_ns) - rtt / 2;",
+			L"",
+			L"\t\t++histogram_[bucket(static_cast<uint64_t>(rtt) / 1000)];",
+			L"\t\t++samples_;",
+			L"\t}",
+			L"",
+			L"\tuint64_t samples() const",
+			L"\t{",
+			L"\t\treturn samples_;",
+			L"\t}",
+			L"",
+			L"\tint64_t last_rtt_ns() const",
+			L"\t{",
+			L"\t\treturn last_rtt_ns_;",
+			L"\t}",
+			L"",
+			L"\tint64_t smoothed_rtt_ns() const",
+			L"\t{",
+			L"\t\treturn srtt_ns_;",
+			L"\t}",
+			L"",
+			L"\tint64_t rtt_deviation_ns() const",
+			L"\t{",
+			L"\t\treturn rttvar_ns_;",
+			L"\t}",
+			L"",
+			L"\tint64_t min_rtt_ns() const",
+			L"\t{",
+			L"\t\treturn min_rtt_ns_;",
+			L"\t}",
+			L"",
+			L"\t// peer clock minus ours, taken from the fastest of the recent round trips since queueing skews the slow ones",
+			L"\tint64_t clock_offset_ns() const",
+			L"\t{",
+			L"\t\tuint64_t count = samples_ < OFFSET_WINDOW ? samples_ : OFFSET_WINDOW;",
+			L"\t\tconst Sample* best = nullptr;",
+			L"",
+			L"\t\tfor (uint64_t i = 0; i < count; ++i)",
+			L"\t\t{",
+			L"\t\t\tif (best == nullptr || window_[i].rtt_ns < best->rtt_ns)",
+			L"\t\t\t{",
+			L"\t\t\t\tbest = &window_[i];",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\treturn best != nullptr ? best->offset_ns : 0;",
+			L"\t}",
+			L"",
+			L"\t// upper edge of the bucket holding the rank, within 1/8 of the true value",
+			L"\tint64_t percentile_ns(double rank) const",
+			L"\t{",
+			L"\t\tuint64_t target = static_cast<uint64_t>(rank * static_cast<double>(samples_) + 0.5);",
+			L"\t\tuint64_t seen = 0;",
+			L"",
+			L"\t\tfor (int i = 0; i < BUCKET_CNT; ++i)",
+			L"\t\t{",
+			L"\t\t\tseen += histogram_[i];",
+			L"",
+			L"\t\t\tif (seen >= target && seen > 0)",
+			L"\t\t\t{",
+			L"\t\t\t\treturn static_cast<int64_t>(bucket_limit(i)) * 1000;",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\treturn 0;",
+			L"\t}",
+			L"",
+			L"\tvoid reset()",
+			L"\t{",
+			L"\t\t*this = PingStats();",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tstruct Sample",
+			L"\t{",
+			L"\t\tint64_t rtt_ns;",
+			L"\t\tint64_t offset_ns;",
+			L"\t};",
+			L"",
+			L"\t// log-linear: 8 linear steps per power of two",
+			L"\tstatic int bucket(uint64_t us)",
+			L"\t{",
+			L"\t\tif (us >= (1ull << 32))",
+			L"\t\t{",
+			L"\t\t\treturn BUCKET_CNT - 1;",
+			L"\t\t}",
+			L"",
+			L"\t\tif (us < (1u << SUB_BUCKET_BITS))",
+			L"\t\t{",
+			L"\t\t\treturn static_cast<int>(us);",
+			L"\t\t}",
+			L"",
+			L"\t\tint msb = SUB_BUCKET_BITS;",
+			L"",
+			L"\t\twhile ((us >> (msb + 1)) != 0)",
+			L"\t\t{",
+			L"\t\t\t++msb;",
+			L"\t\t}",
+			L"",
+			L"\t\tint shift = msb - SUB_BUCKET_BITS;",
+			L"",
+			L"\t\treturn ((shift + 1) << SUB_BUCKET_BITS) + static_cast<int>((us >> shift) & ((1u << SUB_BUCKET_BITS) - 1));",
+			L"\t}",
+			L"",
+			L"\tstatic uint64_t bucket_limit(int index)",
+			L"\t{",
+			L"\t\tif (index < (1 << SUB_BUCKET_BITS))",
+			L"\t\t{",
+			L"\t\t\treturn static_cast<uint64_t>(index) + 1;",
+			L"\t\t}",
+			L"",
+			L"\t\tint shift = (index >> SUB_BUCKET_BITS) - 1;",
+			L"\t\tuint64_t step = static_cast<uint64_t>(index & ((1 << SUB_BUCKET_BITS) - 1));",
+			L"",
+			L"\t\treturn ((1ull << SUB_BUCKET_BITS) + step + 1) << shift;",
+			L"\t}",
+			L"",
+			L"\tuint32_t histogram_[BUCKET_CNT] = {};",
+			L"\tSample window_[OFFSET_WINDOW] = {};",
+			L"\tuint64_t samples_ = 0;",
+			L"\tint64_t last_rtt_ns_ = 0;",
+			L"\tint64_t srtt_ns_ = 0;",
+			L"\tint64_t rttvar_ns_ = 0;",
+			L"\tint64_t min_rtt_ns_ = 0;",
+			L"};",
+			L"",
+			L"// frame_size bytes of header, stamps and trailer room",
+			L"inline void write_ping_frame(char* frame, PingType type, uint8_t payload_size)",
+			L"{",
+			L"\tunsigned int header = PING_CODE | (static_cast<unsigned int>(payload_size) << 8) | (static_cast<unsigned int>(type) << 16);",
+			L"\tmemcpy(frame, &header, PING_HEADER_SIZE);",
+			L"}",
+			L"",
+			L"// ping_send(session, frame, size) is found by ADL and puts a whole frame on the session's connection",
+			L"template <typename Session>",
+			L"bool send_ping(Session* session)",
+			L"{",
+			L"\tchar frame[PING_FRAME_SIZE];",
+			L"\tuint64_t now_ns = ping_clock_ns();",
+			L"",
+			L"\twrite_ping_frame(frame, PING_TYPE, 8);",
+			L"\tmemcpy(frame + PING_HEADER_SIZE, &now_ns, 8);",
+		};
+
+		static const wchar_t* const mid[] =
+		{
+			L"",
+			L"\treturn ping_send(session, frame, sizeof(frame));",
+			L"}",
+			L"",
+			L"// ping_stats(session) is found by ADL and returns the session's PingStats&",
+			L"template <typename Session>",
+			L"bool on_ping_frame(Session* session, PingType type, const char* payload, size_t size)",
+			L"{",
+			L"\tif (type == PING_TYPE)",
+			L"\t{",
+			L"\t\tif (size != 8)",
+			L"\t\t{",
+			L"\t\t\treturn false;",
+			L"\t\t}",
+			L"",
+			L"\t\tchar frame[PONG_FRAME_SIZE];",
+			L"\t\tuint64_t now_ns = ping_clock_ns();",
+			L"",
+			L"\t\twrite_ping_frame(frame, PONG_TYPE, 16);",
+			L"\t\tmemcpy(frame + PING_HEADER_SIZE, payload, 8);",
+			L"\t\tmemcpy(frame + PING_HEADER_SIZE + 8, &now_ns, 8);",
+		};
+
+		static const wchar_t* const tail[] =
+		{
+			L"",
+			L"\t\treturn ping_send(session, frame, sizeof(frame));",
+			L"\t}",
+			L"",
+			L"\tif (size != 16)",
+			L"\t{",
+			L"\t\treturn false;",
+			L"\t}",
+			L"",
+			L"\tuint64_t sent_ns;",
+			L"\tuint64_t peer_ns;",
+			L"\tmemcpy(&sent_ns, payload, 8);",
+			L"\tmemcpy(&peer_ns, payload + 8, 8);",
+			L"",
+			L"\tping_stats(session).on_pong(sent_ns, peer_ns, ping_clock_ns());",
+			L"",
+			L"\treturn true;",
+			L"}",
+		};
+
+		int ping_frame = type_id.header_size + 8 + integrity.trailer_size;
+		int pong_frame = type_id.header_size + 16 + integrity.trailer_size;
+
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, L"#include <chrono>\n#include <cstddef>\n#include <cstdint>\n#include <cstring>\n\n");
+
+		if (integrity.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n\n", igh.filename);
+		}
+
+		print_shared_namespace(header);
+
+		print_tab(header);
+		fwprintf(header.file, L"using PingType = %s;\n\n", type_id.name);
+
+		print_tab(header);
+		fwprintf(header.file, L"inline constexpr PingType PING_TYPE = %d;\n", ping.request_type);
+
+		print_tab(header);
+		fwprintf(header.file, L"inline constexpr PingType PONG_TYPE = %d;\n", ping.reply_type);
+
+		print_tab(header);
+		fwprintf(header.file, L"inline constexpr unsigned int PING_CODE = %s;\n", CODE_VALUE);
+
+		print_tab(header);
+		fwprintf(header.file, L"inline constexpr size_t PING_HEADER_SIZE = %d;\n", type_id.header_size);
+
+		print_tab(header);
+		fwprintf(header.file, L"inline constexpr size_t PING_FRAME_SIZE = %d;\n", ping_frame);
+
+		print_tab(header);
+		fwprintf(header.file, L"inline constexpr size_t PONG_FRAME_SIZE = %d;\n\n", pong_frame);
+
+		print_lines(header, head, sizeof(head) / sizeof(head[0]));
+
+		if (integrity.enable)
+		{
+			print_tab(header);
+			fwprintf(header.file, L"\tframe_guard(session).seal(frame, %d);\n", ping_frame - integrity.trailer_size);
+		}
+
+		print_lines(header, mid, sizeof(mid) / sizeof(mid[0]));
+
+		if (integrity.enable)
+		{
+			print_tab(header);
+			fwprintf(header.file, L"\t\tframe_guard(session).seal(frame, %d);\n", pong_frame - integrity.trailer_size);
+		}
+
+		print_lines(header, tail, sizeof(tail) / sizeof(tail[0]));
+
+		print_shared_close(header);
+	}
+
+	void print_compress(FileInfo& header)
+	{
+		static const wchar_t* const lz[] =
+		{
+			L"// payloads never exceed 255 bytes, so match offsets fit in one byte",
+			L"// packed payload: raw size, then LZ4-style sequences of token (literal count << 4 | match length - 4), literals, offset",
+			L"inline constexpr int MIN_MATCH = 4;",
+			L"",
+			L"inline bool put_length(unsigned char* out, int& pos, int limit, int length)",
+			L"{",
+			L"\tfor (; length >= 255; length -= 255)",
+			L"\t{",
+			L"\t\tif (pos >= limit)",
+			L"\t\t{",
+			L"\t\t\treturn false;",
+			L"\t\t}",
+			L"",
+			L"\t\tout[pos++] = 255;",
+			L"\t}",
+			L"",
+			L"\tif (pos >= limit)",
+			L"\t{",
+			L"\t\treturn false;",
+			L"\t}",
+			L"",
+			L"\tout[pos++] = static_cast<unsigned char>(length);",
+			L"",
+			L"\treturn true;",
+			L"}",
+			L"",
+			L"// match_length 0 closes the block with literals only",
+			L"inline bool put_sequence(unsigned char* out, int& pos, int limit, const unsigned char* literals, int literal_cnt, int match_length, int offset)",
+			L"{",
+			L"\tint literal_code = literal_cnt < 15 ? literal_cnt : 15;",
+			L"\tint match_code = match_length == 0 ? 0 : (match_length - MIN_MATCH < 15 ? match_length - MIN_MATCH : 15);",
+			L"",
+			L"\tif (pos >= limit)",
+			L"\t{",
+			L"\t\treturn false;",
+			L"\t}",
+			L"",
+			L"\tout[pos++] = static_cast<unsigned char>((literal_code << 4) | match_code);",
+			L"",
+			L"\tif (literal_code == 15 && !put_length(out, pos, limit, literal_cnt - 15))",
+			L"\t{",
+			L"\t\treturn false;",
+			L"\t}",
+			L"",
+			L"\tif (literal_cnt > limit - pos)",
+			L"\t{",
+			L"\t\treturn false;",
+			L"\t}",
+			L"",
+			L"\tmemcpy(out + pos, literals, literal_cnt);",
+			L"\tpos += literal_cnt;",
+			L"",
+			L"\tif (match_length == 0)",
+			L"\t{",
+			L"\t\treturn true;",
+			L"\t}",
+			L"",
+			L"\tif (pos >= limit)",
+			L"\t{",
+			L"\t\treturn false;",
+			L"\t}",
+			L"",
+			L"\tout[pos++] = static_cast<unsigned char>(offset);",
+			L"",
+			L"\treturn match_code != 15 || put_length(out, pos, limit, match_length - MIN_MATCH - 15);",
+			L"}",
+			L"",
+			L"// packed size, 0 when the payload would not shrink; out needs size - 1 bytes",
+			L"inline int compress_payload(const char* in, int size, char* out)",
+			L"{",
+			L"\tconst unsigned char* src = reinterpret_cast<const unsigned char*>(in);",
+			L"\tunsigned char* dst = reinterpret_cast<unsigned char*>(out);",
+			L"\tunsigned char table[256] = {}; // last position + 1 per hashed 4-byte word",
+			L"",
+			L"\tint limit = size - 1;",
+			L"\tint pos = 0;",
+			L"\tint anchor = 0;",
+			L"",
+			L"\tif (limit <= 0)",
+			L"\t{",
+			L"\t\treturn 0;",
+			L"\t}",
+			L"",
+			L"\tdst[pos++] = static_cast<unsigned char>(size);",
+			L"",
+			L"\tfor (int i = 0; i + MIN_MATCH <= size;)",
+			L"\t{",
+			L"\t\tuint32_t word;",
+			L"\t\tmemcpy(&word, src + i, sizeof(word));",
+			L"",
+			L"\t\tuint32_t slot = (word * 2654435761u) >> 24;",
+			L"\t\tint candidate = table[slot] - 1;",
+			L"\t\ttable[slot] = static_cast<unsigned char>(i + 1);",
+			L"",
+			L"\t\tif (candidate < 0 || memcmp(src + candidate, src + i, MIN_MATCH) != 0)",
+			L"\t\t{",
+			L"\t\t\t++i;",
+			L"\t\t\tcontinue;",
+			L"\t\t}",
+			L"",
+			L"\t\tint match_length = MIN_MATCH;",
+			L"",
+			L"\t\twhile (i + match_length < size && src[candidate + match_length] == src[i + match_length])",
+			L"\t\t{",
+			L"\t\t\t++match_length;",
+			L"\t\t}",
+			L"",
+			L"\t\tif (!put_sequence(dst, pos, limit, src + anchor, i - anchor, match_length, i - candidate))",
+			L"\t\t{",
+			L"\t\t\treturn 0;",
+			L"\t\t}",
+			L"",
+			L"\t\ti += match_length;",
+			L"\t\tanchor = i;",
+			L"\t}",
+			L"",
+			L"\tif (!put_sequence(dst, pos, limit, src + anchor, size - anchor, 0, 0))",
+			L"\t{",
+			L"\t\treturn 0;",
+			L"\t}",
+			L"",
+			L"\treturn pos;",
+			L"}",
+			L"",
+			L"inline bool get_length(const unsigned char* in, int& pos, int size, int& length)",
+			L"{",
+			L"\tunsigned char part;",
+			L"",
+			L"\tdo",
+			L"\t{",
+			L"\t\tif (pos >= size)",
+			L"\t\t{",
+			L"\t\t\treturn false;",
+			L"\t\t}",
+			L"",
+			L"\t\tpart = in[pos++];",
+			L"\t\tlength += part;",
+			L"\t} while (part == 255);",
+			L"",
+			L"\treturn true;",
+			L"}",
+			L"",
+			L"// raw size, -1 when the packed payload is malformed or does not fit capacity",
+			L"inline int decompress_payload(const char* in, int size, char* out, int capacity)",
+			L"{",
+			L"\tconst unsigned char* src = reinterpret_cast<const unsigned char*>(in);",
+			L"",
+			L"\tif (size < 1 || src[0] > capacity)",
+			L"\t{",
+			L"\t\treturn -1;",
+			L"\t}",
+			L"",
+			L"\tint raw = src[0];",
+			L"\tint pos = 1;",
+			L"\tint written = 0;",
+			L"",
+			L"\tfor (;;)",
+			L"\t{",
+			L"\t\tif (pos >= size)",
+			L"\t\t{",
+			L"\t\t\treturn -1;",
+			L"\t\t}",
+			L"",
+			L"\t\tint token = src[pos++];",
+			L"\t\tint literal_cnt = token >> 4;",
+			L"",
+			L"\t\tif (literal_cnt == 15 && !get_length(src, pos, size, literal_cnt))",
+			L"\t\t{",
+			L"\t\t\treturn -1;",
+			L"\t\t}",
+			L"",
+			L"\t\tif (literal_cnt > size - pos || literal_cnt > raw - written)",
+			L"\t\t{",
+			L"\t\t\treturn -1;",
+			L"\t\t}",
+			L"",
+			L"\t\tmemcpy(out + written, src + pos, literal_cnt);",
+			L"\t\tpos += literal_cnt;",
+			L"\t\twritten += literal_cnt;",
+			L"",
+			L"\t\tif (written == raw)",
+			L"\t\t{",
+			L"\t\t\treturn pos == size ? raw : -1;",
+			L"\t\t}",
+			L"",
+			L"\t\tif (pos >= size)",
+			L"\t\t{",
+			L"\t\t\treturn -1;",
+			L"\t\t}",
+			L"",
+			L"\t\tint offset = src[pos++];",
+			L"\t\tint match_length = (token & 15) + MIN_MATCH;",
+			L"",
+			L"\t\tif ((token & 15) == 15 && !get_length(src, pos, size, match_length))",
+			L"\t\t{",
+			L"\t\t\treturn -1;",
+			L"\t\t}",
+			L"",
+			L"\t\tif (offset == 0 || offset > written || match_length > raw - written)",
+			L"\t\t{",
+			L"\t\t\treturn -1;",
+			L"\t\t}",
+			L"",
+			L"\t\t// byte by byte: the source may overlap the bytes being written",
+			L"\t\tfor (int i = 0; i < match_length; ++i)",
+			L"\t\t{",
+			L"\t\t\tout[written + i] = out[written - offset + i];",
+			L"\t\t}",
+			L"",
+			L"\t\twritten += match_length;",
+			L"\t}",
+			L"}",
+		};
+
+		static const wchar_t* const frame[] =
+		{
+			L"",
+			L"// packs the payload of a frame written at frame in place, returns the frame size to send",
+			L"inline int compress_frame(char* frame, int payload_size)",
+			L"{",
+			L"\tthread_local char packed[255];",
+			L"",
+			L"\tint packed_size = compress_payload(frame + FRAME_HEADER_SIZE, payload_size, packed);",
+			L"",
+			L"\tif (packed_size == 0)",
+			L"\t{",
+			L"\t\treturn FRAME_HEADER_SIZE + payload_size;",
+			L"\t}",
+			L"",
+			L"\tframe[0] = static_cast<char>(COMPRESSED_CODE);",
+			L"\tframe[1] = static_cast<char>(packed_size);",
+			L"\tmemcpy(frame + FRAME_HEADER_SIZE, packed, packed_size);",
+			L"",
+			L"\treturn FRAME_HEADER_SIZE + packed_size;",
+			L"}",
+		};
+
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, L"#include <cstdint>\n#include <cstring>\n\n");
+
+		print_shared_namespace(header);
+
+		print_tab(header);
+		fwprintf(header.file, L"inline constexpr unsigned char COMPRESSED_CODE = %s;\n", COMPRESSED_CODE_VALUE);
+
+		print_tab(header);
+		fwprintf(header.file, L"inline constexpr int COMPRESS_THRESHOLD = %d;\n", compress.threshold);
+
+		print_tab(header);
+		fwprintf(header.file, L"inline constexpr int FRAME_HEADER_SIZE = %d;\n\n", type_id.header_size);
+
+		print_lines(header, lz, sizeof(lz) / sizeof(lz[0]));
+		print_lines(header, frame, sizeof(frame) / sizeof(frame[0]));
+
+		print_shared_close(header);
+	}
+
+	void print_integrity(FileInfo& header)
+	{
+		static const wchar_t* const head[] =
+		{
+			L"// CRC-32C (Castagnoli): SSE4.2 or ARMv8 CRC instructions when present, slice-by-one table otherwise",
+			L"struct Crc32cTable",
+			L"{",
+			L"\tuint32_t entry[256];",
+			L"",
+			L"\tconstexpr Crc32cTable() : entry()",
+			L"\t{",
+			L"\t\tfor (uint32_t i = 0; i < 256; ++i)",
+			L"\t\t{",
+			L"\t\t\tuint32_t crc = i;",
+			L"",
+			L"\t\t\tfor (int bit = 0; bit < 8; ++bit)",
+			L"\t\t\t{",
+			L"\t\t\t\tcrc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tentry[i] = crc;",
+			L"\t\t}",
+			L"\t}",
+			L"};",
+			L"",
+			L"inline constexpr Crc32cTable CRC32C_TABLE{};",
+			L"",
+			L"inline uint32_t crc32c_table(const unsigned char* data, size_t len, uint32_t crc)",
+			L"{",
+			L"\tfor (size_t i = 0; i < len; ++i)",
+			L"\t{",
+			L"\t\tcrc = CRC32C_TABLE.entry[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);",
+			L"\t}",
+			L"",
+			L"\treturn crc;",
+			L"}",
+			L"",
+			L"#if defined(__x86_64__) || defined(_M_X64)",
+			L"#if defined(__GNUC__) || defined(__clang__)",
+			L"__attribute__((target(\"sse4.2\")))",
+			L"#endif",
+			L"inline uint32_t crc32c_hardware(const unsigned char* data, size_t len, uint32_t crc)",
+			L"{",
+			L"\tunsigned long long wide = crc;",
+			L"",
+			L"\tfor (; len >= 8; data += 8, len -= 8)",
+			L"\t{",
+			L"\t\tunsigned long long word;",
+			L"\t\tmemcpy(&word, data, 8);",
+			L"\t\twide = _mm_crc32_u64(wide, word);",
+			L"\t}",
+			L"",
+			L"\tcrc = static_cast<uint32_t>(wide);",
+			L"",
+			L"\tfor (; len > 0; ++data, --len)",
+			L"\t{",
+			L"\t\tcrc = _mm_crc32_u8(crc, *data);",
+			L"\t}",
+			L"",
+			L"\treturn crc;",
+			L"}",
+			L"",
+			L"inline bool crc32c_supported()",
+			L"{",
+			L"#if defined(_MSC_VER)",
+			L"\tint info[4];",
+			L"\t__cpuid(info, 1);",
+			L"\tstatic const bool supported = (info[2] & (1 << 20)) != 0;",
+			L"#else",
+			L"\tstatic const bool supported = __builtin_cpu_supports(\"sse4.2\");",
+			L"#endif",
+			L"\treturn supported;",
+			L"}",
+			L"#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)",
+			L"inline uint32_t crc32c_hardware(const unsigned char* data, size_t len, uint32_t crc)",
+			L"{",
+			L"\tfor (; len >= 8; data += 8, len -= 8)",
+			L"\t{",
+			L"\t\tuint64_t word;",
+			L"\t\tmemcpy(&word, data, 8);",
+			L"\t\tcrc = __crc32cd(crc, word);",
+			L"\t}",
+			L"",
+			L"\tfor (; len > 0; ++data, --len)",
+			L"\t{",
+			L"\t\tcrc = __crc32cb(crc, *data);",
+			L"\t}",
+			L"",
+			L"\treturn crc;",
+			L"}",
+			L"",
+			L"inline bool crc32c_supported()",
+			L"{",
+			L"\treturn true;",
+			L"}",
+			L"#else",
+			L"inline uint32_t crc32c_hardware(const unsigned char* data, size_t len, uint32_t crc)",
+			L"{",
+			L"\treturn crc32c_table(data, len, crc);",
+			L"}",
+			L"",
+			L"inline bool crc32c_supported()",
+			L"{",
+			L"\treturn false;",
+			L"}",
+			L"#endif",
+			L"",
+			L"inline uint32_t crc32c(const void* data, size_t len)",
+			L"{",
+			L"\tconst unsigned char* bytes = static_cast<const unsigned char*>(data);",
+			L"",
+			L"\tif (crc32c_supported())",
+			L"\t{",
+			L"\t\treturn ~crc32c_hardware(bytes, len, ~0u);",
+			L"\t}",
+			L"",
+			L"\treturn ~crc32c_table(bytes, len, ~0u);",
+			L"}",
+			L"",
+			L"// seals frames with a CRC-32C trailer, keyed guards also run payload and trailer through a ChaCha8 keystream",
+			L"// the keystream follows a per-direction frame sequence: keyed frames arrive in the order they were sealed, none dropped",
+			L"// a checksum with a cipher is tamper-evident only against blind tampering, it is not a MAC",
+			L"class FrameGuard",
+			L"{",
+			L"public:",
+		};
+
+		static const wchar_t* const body[] =
+		{
+			L"\tstatic constexpr size_t TRAILER_SIZE = 4;",
+			L"",
+			L"\tFrameGuard() = default;",
+			L"",
+			L"\t// the client and the server pass opposite sides so the two directions never share a keystream",
+			L"\tFrameGuard(const unsigned char (&key)[32], bool client) : send_side_(client ? 1 : 0), keyed_(true)",
+			L"\t{",
+			L"\t\tmemcpy(key_, key, sizeof(key_));",
+			L"\t}",
+			L"",
+			L"\t// frame holds size bytes of header and payload followed by room for the trailer",
+			L"\tvoid seal(char* frame, size_t size)",
+			L"\t{",
+			L"\t\tuint32_t crc = crc32c(frame, size);",
+			L"\t\tmemcpy(frame + size, &crc, TRAILER_SIZE);",
+			L"",
+			L"\t\tif (keyed_)",
+			L"\t\t{",
+			L"\t\t\tapply(send_side_, send_sequence_++, frame + HEADER_SIZE, frame + HEADER_SIZE, size - HEADER_SIZE + TRAILER_SIZE);",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\t// the checked frame, in place or deciphered into scratch, nullptr when the trailer does not match",
+			L"\tconst char* open(const char* frame, size_t size, char* scratch)",
+			L"\t{",
+			L"\t\tconst char* plain = frame;",
+			L"",
+			L"\t\tif (keyed_)",
+			L"\t\t{",
+			L"\t\t\tmemcpy(scratch, frame, HEADER_SIZE);",
+			L"\t\t\tapply(send_side_ ^ 1, recv_sequence_++, frame + HEADER_SIZE, scratch + HEADER_SIZE, size - HEADER_SIZE + TRAILER_SIZE);",
+			L"\t\t\tplain = scratch;",
+			L"\t\t}",
+			L"",
+			L"\t\tuint32_t crc;",
+			L"\t\tmemcpy(&crc, plain + size, TRAILER_SIZE);",
+			L"",
+			L"\t\treturn crc == crc32c(plain, size) ? plain : nullptr;",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tstatic uint32_t rotate(uint32_t value, int bits)",
+			L"\t{",
+			L"\t\treturn (value << bits) | (value >> (32 - bits));",
+			L"\t}",
+			L"",
+			L"\tstatic void quarter(uint32_t* x, int a, int b, int c, int d)",
+			L"\t{",
+			L"\t\tx[a] += x[b]; x[d] = rotate(x[d] ^ x[a], 16);",
+			L"\t\tx[c] += x[d]; x[b] = rotate(x[b] ^ x[c], 12);",
+			L"\t\tx[a] += x[b]; x[d] = rotate(x[d] ^ x[a], 8);",
+			L"\t\tx[c] += x[d]; x[b] = rotate(x[b] ^ x[c], 7);",
+			L"\t}",
+			L"",
+			L"\t// one 64-byte ChaCha8 block, nonce = side and frame sequence, counter = block in the frame",
+			L"\tvoid block(uint32_t side, uint64_t sequence, uint32_t counter, uint32_t* out) const",
+			L"\t{",
+			L"\t\tuint32_t state[16] =",
+			L"\t\t{",
+			L"\t\t\t0x61707865, 0x3320646E, 0x79622D32, 0x6B206574,",
+			L"\t\t\t0, 0, 0, 0, 0, 0, 0, 0,",
+			L"\t\t\tcounter, side, static_cast<uint32_t>(sequence), static_cast<uint32_t>(sequence >> 32),",
+			L"\t\t};",
+			L"",
+			L"\t\tmemcpy(state + 4, key_, sizeof(key_));",
+			L"",
+			L"\t\tuint32_t x[16];",
+			L"\t\tmemcpy(x, state, sizeof(x));",
+			L"",
+			L"\t\tfor (int round = 0; round < 8; round += 2)",
+			L"\t\t{",
+			L"\t\t\tquarter(x, 0, 4, 8, 12);",
+			L"\t\t\tquarter(x, 1, 5, 9, 13);",
+			L"\t\t\tquarter(x, 2, 6, 10, 14);",
+			L"\t\t\tquarter(x, 3, 7, 11, 15);",
+			L"\t\t\tquarter(x, 0, 5, 10, 15);",
+			L"\t\t\tquarter(x, 1, 6, 11, 12);",
+			L"\t\t\tquarter(x, 2, 7, 8, 13);",
+			L"\t\t\tquarter(x, 3, 4, 9, 14);",
+			L"\t\t}",
+			L"",
+			L"\t\tfor (int i = 0; i < 16; ++i)",
+			L"\t\t{",
+			L"\t\t\tout[i] = x[i] + state[i];",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tvoid apply(uint32_t side, uint64_t sequence, const char* in, char* out, size_t len) const",
+			L"\t{",
+			L"\t\tuint32_t stream[16];",
+			L"",
+			L"\t\tfor (size_t offset = 0; offset < len; offset += sizeof(stream))",
+			L"\t\t{",
+			L"\t\t\tblock(side, sequence, static_cast<uint32_t>(offset / sizeof(stream)), stream);",
+			L"",
+			L"\t\t\tconst unsigned char* key_bytes = reinterpret_cast<const unsigned char*>(stream);",
+			L"\t\t\tsize_t count = len - offset < sizeof(stream) ? len - offset : sizeof(stream);",
+			L"",
+			L"\t\t\tfor (size_t i = 0; i < count; ++i)",
+			L"\t\t\t{",
+			L"\t\t\t\tout[offset + i] = static_cast<char>(in[offset + i] ^ key_bytes[i]);",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tuint32_t key_[8] = {};",
+			L"\tuint64_t send_sequence_ = 0;",
+			L"\tuint64_t recv_sequence_ = 0;",
+			L"\tuint32_t send_side_ = 0;",
+			L"\tbool keyed_ = false;",
+			L"};",
+		};
+
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, L"#include <cstddef>\n#include <cstdint>\n#include <cstring>\n\n");
+		fwprintf(header.file, L"#if defined(_MSC_VER)\n#include <intrin.h>\n#elif defined(__x86_64__)\n#include <nmmintrin.h>\n#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)\n#include <arm_acle.h>\n#endif\n\n");
+
+		print_shared_namespace(header);
+
+		print_lines(header, head, sizeof(head) / sizeof(head[0]));
+
+		print_tab(header);
+		fwprintf(header.file, L"\tstatic constexpr size_t HEADER_SIZE = %d;\n\n", type_id.header_size);
+
+		print_lines(header, body, sizeof(body) / sizeof(body[0]));
+
+		print_shared_close(header);
+	}
+
+	void print_gather(FileInfo& header)
+	{
+		static const wchar_t* const head[] =
+		{
+			L"// per-session gather list: frames land in pooled chunks, bulk bytes are referenced in place, one flush sends them all",
+			L"class GatherQueue",
+			L"{",
+			L"public:",
+		};
+
+		static const wchar_t* const body[] =
+		{
+			L"",
+			L"\tGatherQueue() = default;",
+			L"\tGatherQueue(const GatherQueue&) = delete;",
+			L"\tGatherQueue& operator=(const GatherQueue&) = delete;",
+			L"",
+			L"\t// room for one frame, contiguous with the previous frame whenever the chunk allows",
+			L"\tchar* reserve(size_t size)",
+			L"\t{",
+			L"\t\tif (chunks_.empty() || used_ + size > CHUNK_SIZE)",
+			L"\t\t{",
+			L"\t\t\tnext_chunk();",
+			L"\t\t}",
+			L"",
+			L"\t\tchar* memory = chunks_[chunk_].get() + used_;",
+			L"\t\tused_ += size;",
+			L"",
+			L"\t\tappend_segment(memory, size);",
+			L"",
+			L"\t\treturn memory;",
+			L"\t}",
+			L"",
+			L"\t// gives back the tail of the last reserve, e.g. when its frame packed smaller",
+			L"\tvoid shrink(size_t unused)",
+			L"\t{",
+			L"\t\tSegment& last = segments_.back();",
+			L"",
+			L"\t\tset_segment(last, segment_data(last), segment_size(last) - unused);",
+			L"\t\tused_ -= unused;",
+			L"\t}",
+			L"",
+			L"\t// memory is not copied and must stay alive until the flush that sends it",
+			L"\tvoid append_ref(const void* data, size_t size)",
+			L"\t{",
+			L"\t\tsegments_.push_back(make_segment(const_cast<char*>(static_cast<const char*>(data)), size));",
+			L"\t}",
+			L"",
+			L"\tbool empty() const",
+			L"\t{",
+			L"\t\treturn head_ == segments_.size();",
+			L"\t}",
+			L"",
+			L"\tsize_t pending_bytes() const",
+			L"\t{",
+			L"\t\tsize_t bytes = 0;",
+			L"",
+			L"\t\tfor (size_t i = head_; i < segments_.size(); ++i)",
+			L"\t\t{",
+			L"\t\t\tbytes += segment_size(segments_[i]);",
+			L"\t\t}",
+			L"",
+			L"\t\treturn bytes;",
+			L"\t}",
+			L"",
+			L"#ifdef _WIN32",
+			L"\t// one WSASend over the queued segments, bytes sent or -1 on a socket error",
+			L"\tlong long flush(SOCKET socket)",
+			L"\t{",
+			L"\t\tlong long total = 0;",
+			L"",
+			L"\t\twhile (!empty())",
+			L"\t\t{",
+			L"\t\t\tDWORD count = static_cast<DWORD>(segments_.size() - head_);",
+			L"\t\t\tDWORD sent = 0;",
+			L"",
+			L"\t\t\tif (WSASend(socket, segments_.data() + head_, count, &sent, 0, nullptr, nullptr) == SOCKET_ERROR)",
+			L"\t\t\t{",
+			L"\t\t\t\treturn WSAGetLastError() == WSAEWOULDBLOCK ? total : -1;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\ttotal += sent;",
+			L"\t\t\tconsume(sent);",
+			L"\t\t}",
+			L"",
+			L"\t\treturn total;",
+			L"\t}",
+			L"#else",
+			L"\t// writev over the queued segments, bytes written or -1 on a socket error",
+			L"\tlong long flush(int fd)",
+			L"\t{",
+			L"\t\tlong long total = 0;",
+			L"",
+			L"\t\twhile (!empty())",
+			L"\t\t{",
+			L"\t\t\tsize_t count = segments_.size() - head_;",
+			L"\t\t\tssize_t written = writev(fd, segments_.data() + head_, static_cast<int>(count < IOV_MAX ? count : IOV_MAX));",
+			L"",
+			L"\t\t\tif (written < 0)",
+			L"\t\t\t{",
+			L"\t\t\t\treturn errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? total : -1;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\ttotal += written;",
+			L"\t\t\tconsume(static_cast<size_t>(written));",
+			L"\t\t}",
+			L"",
+			L"\t\treturn total;",
+			L"\t}",
+			L"#endif",
+			L"",
+			L"private:",
+			L"#ifdef _WIN32",
+			L"\tusing Segment = WSABUF;",
+			L"",
+			L"\tstatic Segment make_segment(char* data, size_t size)",
+			L"\t{",
+			L"\t\treturn Segment{ static_cast<ULONG>(size), data };",
+			L"\t}",
+			L"",
+			L"\tstatic char* segment_data(const Segment& segment)",
+			L"\t{",
+			L"\t\treturn segment.buf;",
+			L"\t}",
+			L"",
+			L"\tstatic size_t segment_size(const Segment& segment)",
+			L"\t{",
+			L"\t\treturn segment.len;",
+			L"\t}",
+			L"",
+			L"\tstatic void set_segment(Segment& segment, char* data, size_t size)",
+			L"\t{",
+			L"\t\tsegment.buf = data;",
+			L"\t\tsegment.len = static_cast<ULONG>(size);",
+			L"\t}",
+			L"#else",
+			L"\tusing Segment = iovec;",
+			L"",
+			L"\tstatic Segment make_segment(char* data, size_t size)",
+			L"\t{",
+			L"\t\treturn Segment{ data, size };",
+			L"\t}",
+			L"",
+			L"\tstatic char* segment_data(const Segment& segment)",
+			L"\t{",
+			L"\t\treturn static_cast<char*>(segment.iov_base);",
+			L"\t}",
+			L"",
+			L"\tstatic size_t segment_size(const Segment& segment)",
+			L"\t{",
+			L"\t\treturn segment.iov_len;",
+			L"\t}",
+			L"",
+			L"\tstatic void set_segment(Segment& segment, char* data, size_t size)",
+			L"\t{",
+			L"\t\tsegment.iov_base = data;",
+			L"\t\tsegment.iov_len = size;",
+			L"\t}",
+			L"#endif",
+			L"",
+			L"\tvoid append_segment(char* memory, size_t size)",
+			L"\t{",
+			L"\t\tif (head_ < segments_.size())",
+			L"\t\t{",
+			L"\t\t\tSegment& last = segments_.back();",
+			L"",
+			L"\t\t\tif (segment_data(last) + segment_size(last) == memory)",
+			L"\t\t\t{",
+			L"\t\t\t\tset_segment(last, segment_data(last), segment_size(last) + size);",
+			L"\t\t\t\treturn;",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\tsegments_.push_back(make_segment(memory, size));",
+			L"\t}",
+			L"",
+			L"\tvoid next_chunk()",
+			L"\t{",
+			L"\t\tif (!chunks_.empty())",
+			L"\t\t{",
+			L"\t\t\t++chunk_;",
+			L"\t\t}",
+			L"",
+			L"\t\tif (chunk_ == chunks_.size())",
+			L"\t\t{",
+			L"\t\t\tchunks_.push_back(std::make_unique<char[]>(CHUNK_SIZE));",
+			L"\t\t}",
+			L"",
+			L"\t\tused_ = 0;",
+			L"\t}",
+			L"",
+			L"\t// drops sent bytes, once everything is out the chunks are reused from the first one",
+			L"\tvoid consume(size_t bytes)",
+			L"\t{",
+			L"\t\twhile (bytes > 0)",
+			L"\t\t{",
+			L"\t\t\tSegment& segment = segments_[head_];",
+			L"\t\t\tsize_t size = segment_size(segment);",
+			L"",
+			L"\t\t\tif (bytes < size)",
+			L"\t\t\t{",
+			L"\t\t\t\tset_segment(segment, segment_data(segment) + bytes, size - bytes);",
+			L"\t\t\t\treturn;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tbytes -= size;",
+			L"\t\t\t++head_;",
+			L"\t\t}",
+			L"",
+			L"\t\tif (empty())",
+			L"\t\t{",
+			L"\t\t\tsegments_.clear();",
+			L"\t\t\thead_ = 0;",
+			L"\t\t\tchunk_ = 0;",
+			L"\t\t\tused_ = 0;",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tstd::vector<std::unique_ptr<char[]>> chunks_;",
+			L"\tstd::vector<Segment> segments_;",
+			L"\tsize_t chunk_ = 0;",
+			L"\tsize_t used_ = 0;",
+			L"\tsize_t head_ = 0;",
+			L"};",
+		};
+
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, L"#ifdef _WIN32\n#include <winsock2.h>\n#else\n#include <sys/uio.h>\n#include <cerrno>\n#include <climits>\n#endif\n\n");
+		fwprintf(header.file, L"#include <cstddef>\n#include <memory>\n#include <vector>\n\n");
+
+		print_shared_namespace(header);
+
+		print_lines(header, head, sizeof(head) / sizeof(head[0]));
+
+		print_tab(header);
+		fwprintf(header.file, L"\tstatic constexpr size_t CHUNK_SIZE = %d;\n", gather.chunk_size);
+
+		print_lines(header, body, sizeof(body) / sizeof(body[0]));
+
+		print_shared_close(header);
+	}
+
+	void print_send_queue(FileInfo& header)
+	{
+		static const wchar_t* const frame[] =
+		{
+			L"class SendPool;",
+			L"",
+			L"// one encoded frame in a fixed block, linked through next while it is queued or pooled",
+			L"struct SendFrame",
+			L"{",
+			L"\tstd::atomic<SendFrame*> next;",
+			L"\tSendPool* pool = nullptr;",
+			L"\tsize_t size = 0;",
+			L"\talignas(8) char data[SEND_FRAME_CAPACITY];",
+			L"",
+			L"\tchar* reserve(size_t n)",
+			L"\t{",
+			L"\t\tsize = n;",
+			L"\t\treturn data;",
+			L"\t}",
+			L"",
+			L"\tvoid shrink(size_t n)",
+			L"\t{",
+			L"\t\tsize -= n;",
+			L"\t}",
+			L"};",
+			L"",
+			L"// frames of one producer thread: encoded there, handed back by the IO thread once written",
+			L"// a pool outlives its thread, frames still queued point back at it",
+			L"class SendPool",
+			L"{",
+			L"public:",
+			L"\tSendPool(const SendPool&) = delete;",
+			L"\tSendPool& operator=(const SendPool&) = delete;",
+			L"",
+			L"\tstatic SendPool& local()",
+			L"\t{",
+			L"\t\tthread_local SendPool* pool = new SendPool;",
+			L"\t\treturn *pool;",
+			L"\t}",
+			L"",
+			L"\t// owner thread only",
+			L"\tSendFrame& acquire()",
+			L"\t{",
+			L"\t\tif (free_ == nullptr)",
+			L"\t\t{",
+			L"\t\t\trefill();",
+			L"\t\t}",
+			L"",
+			L"\t\tSendFrame* frame = free_;",
+			L"\t\tfree_ = frame->next.load(std::memory_order_relaxed);",
+			L"\t\treturn *frame;",
+			L"\t}",
+			L"",
+			L"\t// any thread, first..last linked through next and all of this pool, one atomic exchange",
+			L"\tvoid release(SendFrame* first, SendFrame* last)",
+			L"\t{",
+			L"\t\treturned_.push(first, last);",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tSendPool() = default;",
+			L"",
+			L"\t// frames the IO thread handed back, fresh ones only when none came",
+			L"\tvoid refill()",
+			L"\t{",
+			L"\t\tfor (SendFrame* frame = returned_.pop(); frame != nullptr; frame = returned_.pop())",
+			L"\t\t{",
+			L"\t\t\tframe->next.store(free_, std::memory_order_relaxed);",
+			L"\t\t\tfree_ = frame;",
+			L"\t\t}",
+			L"",
+			L"\t\tif (free_ != nullptr)",
+			L"\t\t{",
+			L"\t\t\treturn;",
+			L"\t\t}",
+			L"",
+			L"\t\tfor (size_t i = 0; i < SEND_BATCH; ++i)",
+			L"\t\t{",
+			L"\t\t\tSendFrame* frame = new SendFrame;",
+			L"\t\t\tframe->pool = this;",
+			L"\t\t\tframe->next.store(free_, std::memory_order_relaxed);",
+			L"\t\t\tfree_ = frame;",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tSendFrame* free_ = nullptr;",
+			L"\tMpscQueue<SendFrame> returned_;",
+			L"};",
+			L"",
+			L"// frames taken from one SendQueue, alive until the transport has written them and recycle() runs",
+			L"class SendBatch",
+			L"{",
+			L"public:",
+			L"\tSendBatch() = default;",
+			L"\tSendBatch(const SendBatch&) = delete;",
+			L"\tSendBatch& operator=(const SendBatch&) = delete;",
+			L"",
+			L"\t~SendBatch()",
+			L"\t{",
+			L"\t\trecycle();",
+			L"\t}",
+			L"",
+			L"\tsize_t size() const",
+			L"\t{",
+			L"\t\treturn cnt_;",
+			L"\t}",
+			L"",
+			L"\tconst char* data(size_t i) const",
+			L"\t{",
+			L"\t\treturn frames_[i]->data;",
+			L"\t}",
+			L"",
+			L"\tsize_t length(size_t i) const",
+			L"\t{",
+			L"\t\treturn frames_[i]->size;",
+			L"\t}",
+		};
+
+		static const wchar_t* const seal[] =
+		{
+			L"",
+			L"\t// a keyed guard must seal in send order, so the IO thread seals what the producers left open",
+			L"\t// drain tops a batch up, only the frames it added since the last seal are sealed",
+			L"\tvoid seal(FrameGuard* guard)",
+			L"\t{",
+			L"\t\tfor (; sealed_ < cnt_; ++sealed_)",
+			L"\t\t{",
+			L"\t\t\tguard->seal(frames_[sealed_]->data, frames_[sealed_]->size - FrameGuard::TRAILER_SIZE);",
+			L"\t\t}",
+			L"\t}",
+		};
+
+		static const wchar_t* const recycle[] =
+		{
+			L"",
+			L"\t// back to their producers' pools, a run of frames from one pool goes back with one exchange",
+			L"\tvoid recycle()",
+			L"\t{",
+			L"\t\tsize_t i = 0;",
+			L"",
+			L"\t\twhile (i < cnt_)",
+			L"\t\t{",
+			L"\t\t\tSendFrame* first = frames_[i];",
+			L"\t\t\tSendFrame* last = first;",
+			L"",
+			L"\t\t\tfor (++i; i < cnt_ && frames_[i]->pool == first->pool; ++i)",
+			L"\t\t\t{",
+			L"\t\t\t\tlast->next.store(frames_[i], std::memory_order_relaxed);",
+			L"\t\t\t\tlast = frames_[i];",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tfirst->pool->release(first, last);",
+			L"\t\t}",
+			L"",
+			L"\t\tcnt_ = 0;",
+		};
+
+		static const wchar_t* const members[] =
+		{
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tfriend class SendQueue;",
+			L"",
+			L"\tSendFrame* frames_[SEND_BATCH];",
+			L"\tsize_t cnt_ = 0;",
+		};
+
+		static const wchar_t* const queue[] =
+		{
+			L"};",
+			L"",
+			L"// per-session queue of encoded frames: any thread publishes with one atomic exchange, the IO thread drains",
+			L"class SendQueue",
+			L"{",
+			L"public:",
+			L"\tSendQueue() = default;",
+			L"\tSendQueue(const SendQueue&) = delete;",
+			L"\tSendQueue& operator=(const SendQueue&) = delete;",
+			L"",
+			L"\t// any thread",
+			L"\tvoid push(SendFrame* frame)",
+			L"\t{",
+			L"\t\tqueue_.push(frame);",
+			L"\t}",
+			L"",
+			L"\t// IO thread only, tops batch up to SEND_BATCH frames, each producer's frames in the order it pushed them",
+			L"\tsize_t drain(SendBatch& batch)",
+			L"\t{",
+			L"\t\twhile (batch.cnt_ < SEND_BATCH)",
+			L"\t\t{",
+			L"\t\t\tSendFrame* frame = queue_.pop();",
+			L"\t\t\tif (frame == nullptr)",
+			L"\t\t\t{",
+			L"\t\t\t\tbreak;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tbatch.frames_[batch.cnt_++] = frame;",
+			L"\t\t}",
+			L"",
+			L"\t\treturn batch.cnt_;",
+			L"\t}",
+			L"",
+			L"\t// IO thread only, false while a producer is mid-push",
+			L"\tbool empty() const",
+			L"\t{",
+			L"\t\treturn queue_.empty();",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tMpscQueue<SendFrame> queue_;",
+			L"};",
+		};
+
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, L"#include \"%s\"\n", mqh.filename);
+
+		if (integrity.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n", igh.filename);
 		}
 
-		int len = until(line + pos, L" \t\r\n");
-		if (len == 0)
+		fwprintf(header.file, L"\n#include <atomic>\n#include <cstddef>\n\n");
+
+		print_shared_namespace(header);
+
+		// room for the largest frame, the trailer included
+		print_tab(header);
+		fwprintf(header.file, L"static constexpr size_t SEND_FRAME_CAPACITY = %d;\n", type_id.header_size + 255 + integrity.trailer_size);
+
+		print_tab(header);
+		fwprintf(header.file, L"static constexpr size_t SEND_BATCH = %d;\n\n", send_queue.batch);
+
+		print_lines(header, frame, sizeof(frame) / sizeof(frame[0]));
+
+		if (integrity.enable)
 		{
-			return false;
+			print_lines(header, seal, sizeof(seal) / sizeof(seal[0]));
 		}
 
-		protocol.protocol_type = _wtoi(line + pos);
+		print_lines(header, recycle, sizeof(recycle) / sizeof(recycle[0]));
 
-		return true;
+		if (integrity.enable)
+		{
+			print_tab(header);
+			fwprintf(header.file, L"\t\tsealed_ = 0;\n");
+		}
+
+		print_lines(header, members, sizeof(members) / sizeof(members[0]));
+
+		if (integrity.enable)
+		{
+			print_tab(header);
+			fwprintf(header.file, L"\tsize_t sealed_ = 0;\n");
+		}
+
+		print_lines(header, queue, sizeof(queue) / sizeof(queue[0]));
+
+		print_shared_close(header);
 	}
 
-	bool parse_protocol(const wchar_t* line)
+	void print_batch_kernel(FileInfo& header)
 	{
-		int pos = skip(line, L" \t");
-		if (pos == -1)
+		static const wchar_t* const body[] =
 		{
-			return false;
+			L"// one byte-shuffle step: mask picks bytes of a source vector into an output chunk, 0x80 leaves a byte zero",
+			L"struct ShuffleStep",
+			L"{",
+			L"\tunsigned char source;",
+			L"\tunsigned char mask[16];",
+			L"};",
+			L"",
+			L"// turns 16 elements of every column into 16 consecutive frames of frame_size bytes, as frame_size output chunks",
+			L"// source[k] names a field and a 16-byte chunk of its 16 elements, head[j] holds the constant header bytes of chunk j",
+			L"struct ShufflePlan",
+			L"{",
+			L"\tint frame_size;",
+			L"\tint source_cnt;",
+			L"\tconst unsigned char (*source)[2];",
+			L"\tconst unsigned char (*head)[16];",
+			L"\tconst unsigned short* step_end; // steps of chunk j end at step_end[j]",
+			L"\tconst ShuffleStep* step;",
+			L"};",
+			L"",
+			L"#if defined(RPC_SHUFFLE)",
+			L"// columns[f] points at the first of the block's 16 elements of field f",
+			L"inline void shuffle_block(const ShufflePlan& plan, const char* const* columns, char* out)",
+			L"{",
+			L"#if defined(RPC_SHUFFLE_SSSE3)",
+			L"\t__m128i source[255];",
+			L"",
+			L"\tfor (int k = 0; k < plan.source_cnt; ++k)",
+			L"\t{",
+			L"\t\tsource[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columns[plan.source[k][0]] + 16 * plan.source[k][1]));",
+			L"\t}",
+			L"",
+			L"\tint t = 0;",
+			L"",
+			L"\tfor (int j = 0; j < plan.frame_size; ++j)",
+			L"\t{",
+			L"\t\t__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plan.head[j]));",
+			L"",
+			L"\t\tfor (; t < plan.step_end[j]; ++t)",
+			L"\t\t{",
+			L"\t\t\t__m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plan.step[t].mask));",
+			L"\t\t\tchunk = _mm_or_si128(chunk, _mm_shuffle_epi8(source[plan.step[t].source], mask));",
+			L"\t\t}",
+			L"",
+			L"\t\t_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16 * j), chunk);",
+			L"\t}",
+			L"#else",
+			L"\tuint8x16_t source[255];",
+			L"",
+			L"\tfor (int k = 0; k < plan.source_cnt; ++k)",
+			L"\t{",
+			L"\t\tsource[k] = vld1q_u8(reinterpret_cast<const uint8_t*>(columns[plan.source[k][0]] + 16 * plan.source[k][1]));",
+			L"\t}",
+			L"",
+			L"\tint t = 0;",
+			L"",
+			L"\tfor (int j = 0; j < plan.frame_size; ++j)",
+			L"\t{",
+			L"\t\tuint8x16_t chunk = vld1q_u8(plan.head[j]);",
+			L"",
+			L"\t\t// indexes past 15 read as zero, the same as 0x80 for pshufb",
+			L"\t\tfor (; t < plan.step_end[j]; ++t)",
+			L"\t\t{",
+			L"\t\t\tchunk = vorrq_u8(chunk, vqtbl1q_u8(source[plan.step[t].source], vld1q_u8(plan.step[t].mask)));",
+			L"\t\t}",
+			L"",
+			L"\t\tvst1q_u8(reinterpret_cast<uint8_t*>(out + 16 * j), chunk);",
+			L"\t}",
+			L"#endif",
+			L"}",
+			L"#endif",
+		};
+
+		fwprintf(header.file, L"#pragma once\n\n");
+
+		// RPC_SHUFFLE_SCALAR keeps the scalar loop, e.g. to compare both paths
+		fwprintf(header.file, L"#if !defined(RPC_SHUFFLE_SCALAR) && (defined(__SSSE3__) || defined(__AVX2__))\n");
+		fwprintf(header.file, L"#include <immintrin.h>\n#define RPC_SHUFFLE\n#define RPC_SHUFFLE_SSSE3\n");
+		fwprintf(header.file, L"#elif !defined(RPC_SHUFFLE_SCALAR) && (defined(__aarch64__) || defined(_M_ARM64))\n");
+		fwprintf(header.file, L"#include <arm_neon.h>\n#define RPC_SHUFFLE\n#define RPC_SHUFFLE_NEON\n");
+		fwprintf(header.file, L"#endif\n\n");
+
+		print_shared_namespace(header);
+
+		print_lines(header, body, sizeof(body) / sizeof(body[0]));
+
+		print_shared_close(header);
+	}
+
+	void print_batch_test(FileInfo& cpp)
+	{
+		static const wchar_t* const head[] =
+		{
+			L"template <typename T>",
+			L"std::unique_ptr<T[]> random_column(std::mt19937_64& rng, size_t cnt)",
+			L"{",
+			L"\tstd::unique_ptr<T[]> column(new T[cnt]);",
+			L"",
+			L"\tfor (size_t i = 0; i < cnt; ++i)",
+			L"\t{",
+			L"\t\tunsigned long long bits = rng();",
+			L"",
+			L"\t\tif constexpr (std::is_same_v<T, bool>)",
+			L"\t\t{",
+			L"\t\t\tcolumn[i] = (bits & 1) != 0;",
+			L"\t\t}",
+			L"\t\telse",
+			L"\t\t{",
+			L"\t\t\tmemcpy(&column[i], &bits, sizeof(T));",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\treturn column;",
+			L"}",
+		};
+
+		const wchar_t* side_name[2] = { ns.enable_side ? L"server::" : L"", ns.enable_side ? L"client::" : L"" };
+		FileInfo* proxy_header[2] = { &sph, &cph };
+		bool side_enable[2] = { creation.server_side, creation.client_side };
+
+		fwprintf(cpp.file, L"// every [batch] encoder against its scalar mp_* one frame at a time, build it with and without RPC_SHUFFLE_SCALAR\n");
+
+		for (int s_c = SERVER; s_c <= CLIENT; ++s_c)
+		{
+			if (side_enable[s_c])
+			{
+				fwprintf(cpp.file, L"#include \"%s\"\n", proxy_header[s_c]->filename);
+			}
 		}
 
-		int len = until(line + pos, L"(");
-		if (len == 0)
+		fwprintf(cpp.file, L"#include \"%s\"\n\n", serial_buffer.header);
+		fwprintf(cpp.file, L"#include <cstddef>\n#include <cstdio>\n#include <cstring>\n#include <memory>\n#include <random>\n#include <type_traits>\n#include <vector>\n\n");
+
+		if (ns.enable)
 		{
-			return false;
+			fwprintf(cpp.file, L"namespace %s\n{\n", ns.global);
+			++cpp.tab_cnt;
 		}
 
-		int copy_len = min(len, BUFFER_SIZE - 1);
-		wcsncpy_s(protocol.name, BUFFER_SIZE, line + pos, copy_len);
-		protocol.name[copy_len] = L'\0';
+		print_lines(cpp, head, sizeof(head) / sizeof(head[0]));
 
-		for (int i = 0; i <= copy_len; ++i)
+		for (int p = 0; p < protocol_cnt; ++p)
 		{
-			protocol.lower_name[i] = towlower(protocol.name[i]);
+			const Protocol& info = protocols[p];
+			int s_c = info.name[0] == L'S' ? SERVER : CLIENT; // the side whose proxy encodes it
+
+			if (!side_enable[s_c] || !is_batch_encoded(info))
+			{
+				continue;
+			}
+
+			int frame_size = type_id.header_size + info.min_size + integrity.trailer_size;
+
+			fwprintf(cpp.file, L"\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"bool check_%s(%s%s& proxy, %s& %s, std::mt19937_64& rng, size_t cnt)\n",
+				info.lower_name, side_name[s_c], RPC_CLASS[PROXY], serial_buffer.type, serial_buffer.param);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			++cpp.tab_cnt;
+
+			for (int i = 0; i < info.param_cnt; ++i)
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"auto %ss = random_column<%s>(rng, cnt);\n", info.param_name[i], info.param_type[i]);
+			}
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"std::vector<std::byte> frames(cnt * %d);\n", frame_size);
+
+			if (integrity.enable)
+			{
+				// unkeyed guards seal both paths the same way
+				print_tab(cpp);
+				fwprintf(cpp.file, L"FrameGuard batch_guard;\n");
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"FrameGuard scalar_guard;\n");
+			}
+
+			fwprintf(cpp.file, L"\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"if (proxy.mp_%s_batch(frames%s, cnt", info.lower_name, integrity.enable ? L", &batch_guard" : L"");
+
+			for (int i = 0; i < info.param_cnt; ++i)
+			{
+				fwprintf(cpp.file, L", %ss.get()", info.param_name[i]);
+			}
+
+			fwprintf(cpp.file, L") != cnt * %d)\n", frame_size);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tprintf(\"%s x%%zu: wrong size\\n\", cnt);\n", info.name);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn false;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"for (size_t i = 0; i < cnt; ++i)\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tproxy.mp_%s(&%s%s", info.lower_name, serial_buffer.param,
+				integrity.enable && !outbox.enable ? L", &scalar_guard" : L"");
+
+			for (int i = 0; i < info.param_cnt; ++i)
+			{
+				fwprintf(cpp.file, L", %ss[i]", info.param_name[i]);
+			}
+
+			fwprintf(cpp.file, L");\n");
+
+			if (integrity.enable && outbox.enable)
+			{
+				print_direct_seal(cpp, L"scalar_guard", serial_buffer.param, L".");
+			}
+
+			fwprintf(cpp.file, L"\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tif (%s.size() != %d || memcmp(%s.read_pos(), frames.data() + i * %d, %d) != 0)\n",
+				serial_buffer.param, frame_size, serial_buffer.param, frame_size, frame_size);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t\tprintf(\"%s x%%zu: frame %%zu differs\\n\", cnt, i);\n", info.name);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t\treturn false;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t}\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"return true;\n");
+
+			--cpp.tab_cnt;
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		fwprintf(cpp.file, L"\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"int run_batch_checks()\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"std::mt19937_64 rng(1);\n");
+
+		for (int s_c = SERVER; s_c <= CLIENT; ++s_c)
+		{
+			if (side_enable[s_c])
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"%s%s %s_proxy;\n", side_name[s_c], RPC_CLASS[PROXY], RPC_SIDE[s_c]);
+			}
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"%s %s;\n\n", serial_buffer.type, serial_buffer.param);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"// none, short of a block, a block and a tail, many blocks\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"const size_t counts[] = { 0, 1, 15, 16, 17, 33, 1000 };\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"int checks = 0;\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"int failures = 0;\n\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"for (size_t cnt : counts)\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		for (int p = 0; p < protocol_cnt; ++p)
+		{
+			const Protocol& info = protocols[p];
+			int s_c = info.name[0] == L'S' ? SERVER : CLIENT;
+
+			if (side_enable[s_c] && is_batch_encoded(info))
+			{
+				print_tab(cpp);
+				fwprintf(cpp.file, L"\tfailures += check_%s(%s_proxy, %s, rng, cnt) ? 0 : 1;\n", info.lower_name, RPC_SIDE[s_c], serial_buffer.param);
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"\t++checks;\n");
+			}
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n\n");
+
+		fwprintf(cpp.file, L"#if defined(RPC_SHUFFLE)\n");
+		print_tab(cpp);
+		fwprintf(cpp.file, L"const char* path = \"shuffle kernel\";\n");
+		fwprintf(cpp.file, L"#else\n");
+		print_tab(cpp);
+		fwprintf(cpp.file, L"const char* path = \"scalar\";\n");
+		fwprintf(cpp.file, L"#endif\n\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"printf(\"%%d of %%d batch encoder checks match the scalar encoders (%%s)\\n\", checks - failures, checks, path);\n\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"return failures == 0 ? 0 : 1;\n");
+
+		--cpp.tab_cnt;
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n");
+
+		if (ns.enable)
+		{
+			--cpp.tab_cnt;
+			fwprintf(cpp.file, L"}\n");
+		}
+
+		fwprintf(cpp.file, L"\nint main()\n{\n\treturn %s%srun_batch_checks();\n}\n", ns.enable ? ns.global : L"", ns.enable ? L"::" : L"");
+
+		fclose(cpp.file);
+		cpp.file = nullptr;
+	}
+
+	void print_string_test(FileInfo& cpp)
+	{
+		static const wchar_t* const head[] =
+		{
+			L"// len units, at most max_len, that change with the length and the position, so a view at a wrong offset reads other ones",
+			L"template <typename Char>",
+			L"std::basic_string<Char> sample(int len, int max_len, int seed)",
+			L"{",
+			L"\tstd::basic_string<Char> text(len < max_len ? len : max_len, Char());",
+			L"",
+			L"\tfor (size_t i = 0; i < text.size(); ++i)",
+			L"\t{",
+			L"\t\ttext[i] = static_cast<Char>((sizeof(Char) == 1 ? 'a' : 0xAC00) + (len * 7 + static_cast<int>(i) + seed) % 26);",
+			L"\t}",
+			L"",
+			L"\treturn text;",
+			L"}",
+		};
+
+		FileInfo* headers[4] = { &sph, &cph, &ssh, &csh };
+
+		fwprintf(cpp.file, L"// every string message from its proxy through the other side's stub at each length up to its N, wstring<N> units at odd offsets included\n");
+
+		for (FileInfo* header : headers)
+		{
+			fwprintf(cpp.file, L"#include \"%s\"\n", header->filename);
+		}
+
+		fwprintf(cpp.file, L"#include \"%s\"\n\n", serial_buffer.header);
+		fwprintf(cpp.file, L"#include <cstdio>\n#include <string>\n#include <string_view>\n\n");
+
+		if (ns.enable)
+		{
+			fwprintf(cpp.file, L"namespace %s\n{\n", ns.global);
+			++cpp.tab_cnt;
+		}
+
+		print_lines(cpp, head, sizeof(head) / sizeof(head[0]));
+
+		fwprintf(cpp.file, L"\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"// the frame in %s as the receiving side's dispatch sees it\n", serial_buffer.param);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"template <typename Stub>\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"bool deliver(Stub& stub, %s& %s, %s type)\n", serial_buffer.type, serial_buffer.param, type_id.name);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"\tconst char* frame = reinterpret_cast<const char*>(%s.read_pos());\n", serial_buffer.param);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"\tint size = static_cast<unsigned char>(frame[1]);\n\n");
+
+		if (compress.enable)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tif (static_cast<unsigned char>(frame[0]) == COMPRESSED_CODE)\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t\treturn stub.dispatch_compressed(nullptr, type, frame + %d, size);\n", type_id.header_size);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\t}\n\n");
+		}
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"\treturn stub.dispatch(nullptr, type, frame + %d, size);\n", type_id.header_size);
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n");
+
+		for (int s_c = SERVER; s_c <= CLIENT; ++s_c)
+		{
+			print_string_check(cpp, s_c);
+		}
+
+		fwprintf(cpp.file, L"\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"int run_string_checks()\n");
+
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
+
+		++cpp.tab_cnt;
+
+		for (int s_c = SERVER; s_c <= CLIENT; ++s_c)
+		{
+			print_tab(cpp);
+			fwprintf(cpp.file, L"%s::%s %s_proxy;\n", RPC_SIDE[s_c], RPC_CLASS[PROXY], RPC_SIDE[s_c]);
 		}
 
-		pos = pos + len + 1; // (  Ŵ
+		print_tab(cpp);
+		fwprintf(cpp.file, L"ServerCheck server_stub;\n");
 
-		int end_pos = pos + until(line + pos, L")");
+		print_tab(cpp);
+		fwprintf(cpp.file, L"ClientCheck client_stub;\n");
 
-		while (pos < end_pos && protocol.param_cnt < MAX_PARAMETER_CNT)
-		{
-			while (line[pos] == L' ' || line[pos] == L'\t')
-			{
-				++pos;
-			}
+		print_tab(cpp);
+		fwprintf(cpp.file, L"%s %s;\n", serial_buffer.type, serial_buffer.param);
 
-			len = until(line + pos, L",)");
+		print_tab(cpp);
+		fwprintf(cpp.file, L"int checks = 0;\n");
 
-			while (line[pos + len - 1] == L' ' || line[pos + len - 1] == L'\t')
-			{
-				--len;
-			}
+		print_tab(cpp);
+		fwprintf(cpp.file, L"int failures = 0;\n\n");
 
-			// pos = Ȯ Ÿ  ε, len = Ÿ + ̸ 
+		for (int p = 0; p < protocol_cnt; ++p)
+		{
+			const Protocol& info = protocols[p];
 
-			int name_len = 1;
-			while (line[pos + len - name_len] != L' ')
+			if (!has_string(info))
 			{
-				++name_len;
+				continue;
 			}
 
-			// name_len  ̽ٸ  
+			// the proxy of one side, the stub of the other
+			int s_c = is_stub_of(info, CLIENT) ? CLIENT : SERVER;
 
-			int type_len = len - name_len;
+			print_tab(cpp);
+			fwprintf(cpp.file, L"failures += check_%s(%s_proxy, %s_stub, %s) ? 0 : 1;\n",
+				info.lower_name, RPC_SIDE[s_c ^ 1], RPC_SIDE[s_c], serial_buffer.param);
 
-			wcsncpy_s(protocol.param_type[protocol.param_cnt], BUFFER_SIZE, line + pos, type_len);
+			print_tab(cpp);
+			fwprintf(cpp.file, L"++checks;\n\n");
+		}
 
-			pos = pos + type_len + 1;
+		print_tab(cpp);
+		fwprintf(cpp.file, L"printf(\"%%d of %%d string messages decode at every length\\n\", checks - failures, checks);\n\n");
 
-			wcsncpy_s(protocol.param_name[protocol.param_cnt], BUFFER_SIZE, line + pos, name_len - 1);
+		print_tab(cpp);
+		fwprintf(cpp.file, L"return failures == 0 ? 0 : 1;\n");
 
-			len = until(line + pos, L",)");
+		--cpp.tab_cnt;
 
-			pos = pos + len + 1;
+		print_tab(cpp);
+		fwprintf(cpp.file, L"}\n");
 
-			++protocol.param_cnt;
+		if (ns.enable)
+		{
+			--cpp.tab_cnt;
+			fwprintf(cpp.file, L"}\n");
 		}
 
-		print_protocol();
-
-		++protocol.protocol_type;
-
-		protocol.param_cnt = 0;
+		fwprintf(cpp.file, L"\nint main()\n{\n\treturn %s%srun_string_checks();\n}\n", ns.enable ? ns.global : L"", ns.enable ? L"::" : L"");
 
-		return true;
+		fclose(cpp.file);
+		cpp.file = nullptr;
 	}
 
-	int until(const wchar_t* line, const wchar_t* token)
+	// a stub of side s_c that keeps the parameters of its last string message, and a check per string message it receives
+	void print_string_check(FileInfo& cpp, int s_c)
 	{
-		int token_cnt = static_cast<int>(wcslen(token));
-		int len = 0;
+		const wchar_t* check_name[2] = { L"ServerCheck", L"ClientCheck" };
 
-		while (line[len])
-		{
-			bool matched = false;
+		fwprintf(cpp.file, L"\n");
 
-			for (int i = 0; i < token_cnt; ++i)
-			{
-				if (line[len] == token[i])
-				{
-					matched = true;
-					break;
-				}
-			}
+		print_tab(cpp);
+		fwprintf(cpp.file, L"class %s : public %s::%s\n", check_name[s_c], RPC_SIDE[s_c], RPC_CLASS[STUB]);
 
-			if (matched)
-			{
-				break;
-			}
+		print_tab(cpp);
+		fwprintf(cpp.file, L"{\n");
 
-			++len;
-		}
+		print_tab(cpp);
+		fwprintf(cpp.file, L"public:\n");
 
-		return len;
-	}
+		++cpp.tab_cnt;
 
-	int skip(const wchar_t* line, const wchar_t* token)
-	{
-		int token_cnt = static_cast<int>(wcslen(token));
-		int len = 0;
+		bool first = true;
 
-		while (line[len])
+		for (int p = 0; p < protocol_cnt; ++p)
 		{
-			bool matched = false;
+			const Protocol& info = protocols[p];
 
-			for (int i = 0; i < token_cnt; ++i)
+			if (!is_stub_of(info, s_c))
 			{
-				if (line[len] == token[i])
-				{
-					matched = true;
-					++len;
-					break;
-				}
+				continue;
 			}
 
-			if (!matched)
+			bool strings = has_string(info);
+
+			if (!first)
 			{
-				break;
+				fwprintf(cpp.file, L"\n");
 			}
-		}
-
-		return line[len] == L'\0' ? -1 : len;
-	}
 
-	void print_header(FileInfo& header, FileInfo& cpp, int s_c, int s_p)
-	{
-		fwprintf(header.file, L"#pragma once\n\n");
-		fwprintf(cpp.file, L"#include \"%s\"\n\n", header.filename);
+			first = false;
 
-		if (s_p == STUB)
-		{
-			fwprintf(header.file, L"#include \"");
-			fwprintf(cpp.file, L"#include \"");
+			print_tab(cpp);
+			fwprintf(cpp.file, L"bool %s(%s::%s*", info.lower_name, RPC_SIDE[s_c], session.type);
 
-			if (ns.enable || session.global_prefix)
+			for (int i = 0; i < info.param_cnt; ++i)
 			{
-				fwprintf(header.file, L"%s_", ns.global);
-				fwprintf(cpp.file, L"%s_", ns.global);
+				fwprintf(cpp.file, strings ? L", %s %s" : L", %s", info.param_type[i], info.param_name[i]);
 			}
 
-			if (session.side_prefix)
-			{
-				fwprintf(header.file, L"%s_", RPC_SIDE[s_c]);
-				fwprintf(cpp.file, L"%s_", RPC_SIDE[s_c]);
-			}
+			fwprintf(cpp.file, L") override\n");
 
-			fwprintf(header.file, L"%s\"\n\n", session.header);
-			fwprintf(cpp.file, L"%s\"\n\n", session.header);
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
 
-			if (logger.enable)
+			if (strings)
 			{
-				fwprintf(cpp.file, L"#include \"%s\"\n", logger.header);
-			}
+				print_tab(cpp);
+				fwprintf(cpp.file, L"\t++calls;\n");
 
-			if (profiler.enable)
-			{
-				fwprintf(cpp.file, L"#include \"%s\"\n", profiler.header);
+				for (int i = 0; i < info.param_cnt; ++i)
+				{
+					print_tab(cpp);
+					fwprintf(cpp.file, L"\t%s_%s = %s;\n", info.lower_name, info.param_name[i], info.param_name[i]);
+				}
 			}
-		}
 
-		fwprintf(header.file, L"#include \"%s\"\n", serial_buffer.header);
-		fwprintf(cpp.file, L"#include \"%s\"\n", serial_buffer.header);
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn true;\n");
 
-		if (s_p == PROXY)
-		{
-			fwprintf(header.file, L"\n#define WIN32_LEAN_AND_MEAN\n#include <Windows.h>\n");
-			fwprintf(cpp.file, L"\n#define WIN32_LEAN_AND_MEAN\n#include <Windows.h>\n");
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
 		}
 
-		if (try_catch.enable)
+		if (!first)
 		{
-			fwprintf(cpp.file, L"\n#include <stdexcept>\n");
+			fwprintf(cpp.file, L"\n");
 		}
 
-		fwprintf(header.file, L"\n");
-		fwprintf(cpp.file, L"\n");
-	}
+		print_tab(cpp);
+		fwprintf(cpp.file, L"int calls = 0;\n");
 
-	void print_namespace(FileInfo& header, FileInfo& cpp, int s_c)
-	{
-		if (ns.enable)
+		for (int p = 0; p < protocol_cnt; ++p)
 		{
-			fwprintf(header.file, L"namespace %s\n", ns.global);
-			fwprintf(cpp.file, L"namespace %s\n", ns.global);
+			const Protocol& info = protocols[p];
 
-			fwprintf(header.file, L"{\n");
-			fwprintf(cpp.file, L"{\n");
-
-			++header.tab_cnt;
-			++cpp.tab_cnt;
-
-			if (ns.enable_side)
+			if (!is_stub_of(info, s_c) || !has_string(info))
 			{
-				print_tab(header);
-				fwprintf(header.file, L"namespace %s\n", RPC_SIDE[s_c]);
+				continue;
+			}
 
-				print_tab(cpp);
-				fwprintf(cpp.file, L"namespace %s\n", RPC_SIDE[s_c]);
+			for (int i = 0; i < info.param_cnt; ++i)
+			{
+				const wchar_t* type = info.param_type[i];
 
-				print_tab(header);
-				fwprintf(header.file, L"{\n");
+				if (info.param_length[i] > 0)
+				{
+					type = info.param_size[i] == 2 ? L"std::u16string" : L"std::string";
+				}
 
 				print_tab(cpp);
-				fwprintf(cpp.file, L"{\n");
-
-				++header.tab_cnt;
-				++cpp.tab_cnt;
+				fwprintf(cpp.file, L"%s %s_%s{};\n", type, info.lower_name, info.param_name[i]);
 			}
 		}
-		else if (ns.enable_side)
-		{
-			fwprintf(header.file, L"namespace %s\n", RPC_SIDE[s_c]);
-			fwprintf(cpp.file, L"namespace %s\n", RPC_SIDE[s_c]);
-
-			fwprintf(header.file, L"{\n");
-			fwprintf(cpp.file, L"{\n");
-
-			++header.tab_cnt;
-			++cpp.tab_cnt;
-		}
-	}
-
-	void print_class(FileInfo& header, int s_p)
-	{
-		print_tab(header);
-		fwprintf(header.file, L"class %s\n", RPC_CLASS[s_p]);
-
-		print_tab(header);
-		fwprintf(header.file, L"{\n");
 
-		print_tab(header);
-		fwprintf(header.file, L"public:\n");
+		--cpp.tab_cnt;
 
-		++header.tab_cnt;
+		print_tab(cpp);
+		fwprintf(cpp.file, L"};\n");
 
-		if (s_p == STUB)
+		for (int p = 0; p < protocol_cnt; ++p)
 		{
-			print_tab(header);
-			fwprintf(header.file, L"virtual ~%s() {}\n\n", RPC_CLASS[s_p]);
-		}
-	}
-
-	void print_dispatch_stub(FileInfo& header, FileInfo& cpp)
-	{
-		print_tab(header);
-		fwprintf(header.file, L"bool dispatch(%s* %s, unsigned char type, %s* %s);\n\n",
-			session.type, session.param, serial_buffer.type, serial_buffer.param);
+			const Protocol& info = protocols[p];
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"bool %s::dispatch(%s* %s, unsigned char type, %s* %s)\n",
-			RPC_CLASS[STUB], session.type, session.param, serial_buffer.type, serial_buffer.param);
+			if (!is_stub_of(info, s_c) || !has_string(info))
+			{
+				continue;
+			}
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"{\n");
+			int max_len = 0;
 
-		++cpp.tab_cnt;
+			for (int i = 0; i < info.param_cnt; ++i)
+			{
+				max_len = info.param_length[i] > max_len ? info.param_length[i] : max_len;
+			}
 
-		if (profiler.enable)
-		{
-			print_tab(cpp);
-			fwprintf(cpp.file, L"%s\n\n", profiler.expression);
-		}
+			fwprintf(cpp.file, L"\n");
 
-		if (try_catch.enable)
-		{
 			print_tab(cpp);
-			fwprintf(cpp.file, L"try\n");
+			fwprintf(cpp.file, L"bool check_%s(%s::%s& proxy, %s& stub, %s& %s)\n",
+				info.lower_name, RPC_SIDE[s_c ^ 1], RPC_CLASS[PROXY], check_name[s_c], serial_buffer.type, serial_buffer.param);
 
 			print_tab(cpp);
 			fwprintf(cpp.file, L"{\n");
 
 			++cpp.tab_cnt;
-		}
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"switch (type)\n");
+			print_tab(cpp);
+			fwprintf(cpp.file, L"for (int len = 0; len <= %d; ++len)\n", max_len);
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"{\n");
-	}
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
 
-	void print_protocol()
-	{
-		if (protocol.name[0] == L'S') // server proxy, client stub 
-		{
-			if (creation.server_side)
+			++cpp.tab_cnt;
+
+			for (int i = 0; i < info.param_cnt; ++i)
 			{
-				print_protocol_proxy(sph, spc);
+				print_tab(cpp);
+				if (info.param_length[i] > 0)
+				{
+					fwprintf(cpp.file, L"%s %s = sample<%s>(len, %d, %d);\n", info.param_size[i] == 2 ? L"std::u16string" : L"std::string",
+						info.param_name[i], info.param_size[i] == 2 ? L"char16_t" : L"char", info.param_length[i], i);
+				}
+				else
+				{
+					fwprintf(cpp.file, i == 0 ? L"%s %s = static_cast<%s>(len);\n" : L"%s %s = static_cast<%s>(len + %d);\n",
+						info.param_type[i], info.param_name[i], info.param_type[i], i);
+				}
 			}
 
-			if (creation.client_side)
+			fwprintf(cpp.file, L"\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"proxy.mp_%s(&%s%s", info.lower_name, serial_buffer.param, integrity.enable && !outbox.enable ? L", nullptr" : L"");
+
+			for (int i = 0; i < info.param_cnt; ++i)
 			{
-				print_protocol_stub(csh, csc);
+				fwprintf(cpp.file, L", %s", info.param_name[i]);
 			}
-		}
-		else // L'C' -> server stub, client proxy 
-		{
-			if (creation.server_side)
+
+			fwprintf(cpp.file, L");\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"stub.calls = 0;\n\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"if (!deliver(stub, %s, %d) || stub.calls != 1", serial_buffer.param, info.protocol_type);
+
+			for (int i = 0; i < info.param_cnt; ++i)
 			{
-				print_protocol_stub(ssh, ssc);
+				fwprintf(cpp.file, L"\n");
+
+				print_tab(cpp);
+				fwprintf(cpp.file, L"\t|| stub.%s_%s != %s", info.lower_name, info.param_name[i], info.param_name[i]);
 			}
 
-			if (creation.client_side)
-			{
-				print_protocol_proxy(cph, cpc);
-			}
+			fwprintf(cpp.file, L")\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"{\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\tprintf(\"%s at length %%d: the stub decoded other parameters\\n\", len);\n", info.name);
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"\treturn false;\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
+
+			--cpp.tab_cnt;
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n\n");
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"return true;\n");
+
+			--cpp.tab_cnt;
+
+			print_tab(cpp);
+			fwprintf(cpp.file, L"}\n");
 		}
 	}
 
-	void print_protocol_stub(FileInfo& header, FileInfo& cpp)
+	void print_stream(FileInfo& header)
 	{
-		print_tab(header);
-		fwprintf(header.file, L"virtual bool %s(%s* %s, %s* %s) = 0;\n",
-			protocol.lower_name, session.type, session.param, serial_buffer.type, serial_buffer.param);
+		static const wchar_t* const head[] =
+		{
+			L"// cuts a byte stream into frames for Stub::dispatch(session, type, payload, size), a split frame waits for the next feed",
+			L"template <typename Stub, typename Session>",
+			L"class StreamDispatcher",
+			L"{",
+			L"public:",
+		};
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"case %d:\n", protocol.protocol_type);
+		static const wchar_t* const body[] =
+		{
+			L"\tstatic constexpr size_t HEADER_SIZE = 2 + sizeof(Type);",
+			L"\tstatic constexpr size_t FRAME_CAPACITY = HEADER_SIZE + 255 + TRAILER_SIZE;",
+			L"",
+			L"\tStreamDispatcher(Stub& stub, Session* session) : stub_(&stub), session_(session)",
+			L"\t{",
+			L"\t}",
+			L"",
+			L"\t// false on a broken frame or a rejected message, the connection should be closed",
+			L"\tbool feed(const char* data, size_t len)",
+			L"\t{",
+			L"\t\twhile (carry_size_ > 0)",
+			L"\t\t{",
+			L"\t\t\tsize_t want = carry_size_ < HEADER_SIZE ? HEADER_SIZE : frame_size(carry_);",
+			L"",
+			L"\t\t\tif (want == 0)",
+			L"\t\t\t{",
+			L"\t\t\t\treturn false;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tsize_t take = want - carry_size_ < len ? want - carry_size_ : len;",
+			L"",
+			L"\t\t\tmemcpy(carry_ + carry_size_, data, take);",
+			L"\t\t\tcarry_size_ += take;",
+			L"\t\t\tdata += take;",
+			L"\t\t\tlen -= take;",
+			L"",
+			L"\t\t\tif (carry_size_ < want)",
+			L"\t\t\t{",
+			L"\t\t\t\treturn true;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tif (carry_size_ == frame_size(carry_))",
+			L"\t\t\t{",
+			L"\t\t\t\tcarry_size_ = 0;",
+			L"",
+			L"\t\t\t\tif (!dispatch(carry_))",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\treturn false;",
+			L"\t\t\t\t}",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\twhile (len >= HEADER_SIZE)",
+			L"\t\t{",
+			L"\t\t\tsize_t size = frame_size(data);",
+			L"",
+			L"\t\t\tif (size == 0)",
+			L"\t\t\t{",
+			L"\t\t\t\treturn false;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tif (len < size)",
+			L"\t\t\t{",
+			L"\t\t\t\tbreak;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tif (!dispatch(data))",
+			L"\t\t\t{",
+			L"\t\t\t\treturn false;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tdata += size;",
+			L"\t\t\tlen -= size;",
+			L"\t\t}",
+			L"",
+			L"\t\tmemcpy(carry_, data, len);",
+			L"\t\tcarry_size_ = len;",
+			L"",
+			L"\t\treturn true;",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\t// whole frame length from its header, 0 when the code byte is wrong",
+			L"\tstatic size_t frame_size(const char* frame)",
+			L"\t{",
+			L"\t\tif ((static_cast<unsigned char>(frame[0]) & CODE_MASK) != CODE)",
+			L"\t\t{",
+			L"\t\t\treturn 0;",
+			L"\t\t}",
+			L"",
+			L"\t\treturn HEADER_SIZE + static_cast<unsigned char>(frame[1]) + TRAILER_SIZE;",
+			L"\t}",
+			L"",
+		};
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"\treturn %s(%s, %s);\n",
-			protocol.lower_name, session.param, serial_buffer.param);
-	}
+		static const wchar_t* const plain[] =
+		{
+			L"\tbool dispatch(const char* checked)",
+			L"\t{",
+		};
 
-	void print_protocol_proxy(FileInfo& header, FileInfo& cpp)
-	{
-		print_tab(header);
-		fwprintf(header.file, L"void mp_%s(%s* %s, ",
-			protocol.lower_name, serial_buffer.type, serial_buffer.param);
+		static const wchar_t* const guarded[] =
+		{
+			L"\t// the trailer is checked, and a keyed frame deciphered, before the stub sees it",
+			L"\tbool dispatch(const char* frame)",
+			L"\t{",
+			L"\t\tsize_t size = HEADER_SIZE + static_cast<unsigned char>(frame[1]);",
+			L"\t\tconst char* checked = frame_guard(session_).open(frame, size, scratch_);",
+			L"",
+			L"\t\tif (checked == nullptr)",
+			L"\t\t{",
+			L"\t\t\treturn false;",
+			L"\t\t}",
+			L"",
+		};
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"void %s::mp_%s(%s* %s, ",
-			RPC_CLASS[PROXY], protocol.lower_name, serial_buffer.type, serial_buffer.param);
+		static const wchar_t* const call[] =
+		{
+			L"\t\tType type;",
+			L"\t\tmemcpy(&type, checked + 2, sizeof(Type));",
+			L"",
+		};
 
-		for (int i = 0; i < protocol.param_cnt; ++i)
+		static const wchar_t* const pinged[] =
 		{
-			fwprintf(header.file, L"%s %s", protocol.param_type[i], protocol.param_name[i]);
-			fwprintf(cpp.file, L"%s %s", protocol.param_type[i], protocol.param_name[i]);
+			L"\t\t// answered and measured here, the stub never sees ping frames",
+			L"\t\tif (type == PING_TYPE || type == PONG_TYPE)",
+			L"\t\t{",
+			L"\t\t\treturn on_ping_frame(session_, type, checked + HEADER_SIZE, static_cast<unsigned char>(checked[1]));",
+			L"\t\t}",
+			L"",
+		};
 
-			if (i != protocol.param_cnt - 1)
-			{
-				fwprintf(header.file, L", ");
-				fwprintf(cpp.file, L", ");
-			}
-		}
-		fwprintf(header.file, L");\n");
-		fwprintf(cpp.file, L")\n");
+		static const wchar_t* const packed[] =
+		{
+			L"\t\tif (static_cast<unsigned char>(checked[0]) == COMPRESSED_CODE)",
+			L"\t\t{",
+			L"\t\t\treturn stub_->dispatch_compressed(session_, type, checked + HEADER_SIZE, static_cast<unsigned char>(checked[1]));",
+			L"\t\t}",
+			L"",
+		};
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"{\n");
+		static const wchar_t* const tail[] =
+		{
+			L"\t\treturn stub_->dispatch(session_, type, checked + HEADER_SIZE, static_cast<unsigned char>(checked[1]));",
+			L"\t}",
+			L"",
+			L"\tStub* stub_;",
+			L"\tSession* session_;",
+			L"\tsize_t carry_size_ = 0;",
+			L"\tchar carry_[FRAME_CAPACITY];",
+		};
 
-		++cpp.tab_cnt;
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, L"#include <cstddef>\n#include <cstring>\n\n");
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"unsigned char code = %s;\n", CODE_VALUE);
+		if (compress.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n", czh.filename);
+		}
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"unsigned char size = 0;\n");
+		if (integrity.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n", igh.filename);
+		}
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"unsigned char type = %d;\n", protocol.protocol_type);
+		if (ping.enable)
+		{
+			fwprintf(header.file, L"#include \"%s\"\n", pgh.filename);
+		}
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"%s->clear();\n", serial_buffer.param);
+		if (compress.enable || integrity.enable || ping.enable)
+		{
+			fwprintf(header.file, L"\n");
+		}
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"*%s << code << size << type << ", serial_buffer.param);
+		print_shared_namespace(header);
 
-		for (int i = 0; i < protocol.param_cnt; ++i)
+		if (integrity.enable)
 		{
-			fwprintf(cpp.file, L"%s", protocol.param_name[i]);
+			print_tab(header);
+			fwprintf(header.file, L"// frame_guard(session) is found by ADL and returns the session's FrameGuard&\n");
+		}
 
-			if (i != protocol.param_cnt - 1)
-			{
-				fwprintf(cpp.file, L" << ");
-			}
+		if (ping.enable)
+		{
+			print_tab(header);
+			fwprintf(header.file, L"// ping frames go to on_ping_frame(), which needs ping_stats(session) and ping_send(session, frame, size)\n");
 		}
 
-		fwprintf(cpp.file, L";\n");
+		print_lines(header, head, sizeof(head) / sizeof(head[0]));
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"reinterpret_cast<unsigned char*>(%s->read_pos())[1] = static_cast<unsigned char>(%s->size() - 3);\n",
-			serial_buffer.param, serial_buffer.param);
+		print_tab(header);
+		fwprintf(header.file, L"\tusing Type = %s;\n\n", type_id.name);
 
-		--cpp.tab_cnt;
+		print_tab(header);
+		fwprintf(header.file, L"\tstatic constexpr unsigned char CODE = %s;\n", CODE_VALUE);
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"}\n\n");
-	}
+		// the mask lets the packed-payload bit through when compression is on
+		print_tab(header);
+		fwprintf(header.file, L"\tstatic constexpr unsigned char CODE_MASK = %s;\n", compress.enable ? L"0xFD" : L"0xFF");
 
-	void print_close()
-	{
-		if (creation.server_side)
+		print_tab(header);
+		fwprintf(header.file, L"\tstatic constexpr size_t TRAILER_SIZE = %d;\n", integrity.trailer_size);
+
+		print_lines(header, body, sizeof(body) / sizeof(body[0]));
+
+		if (integrity.enable)
 		{
-			print_close_stub(ssh, ssc);
-			print_close_proxy(sph, spc);
+			print_lines(header, guarded, sizeof(guarded) / sizeof(guarded[0]));
 		}
-
-		if (creation.client_side)
+		else
 		{
-			print_close_stub(csh, csc);
-			print_close_proxy(cph, cpc);
+			print_lines(header, plain, sizeof(plain) / sizeof(plain[0]));
 		}
-	}
 
-	void print_close_stub(FileInfo& header, FileInfo& cpp)
-	{
-		--header.tab_cnt;
-		print_tab(header);
-		fwprintf(header.file, L"};\n"); // class
+		print_lines(header, call, sizeof(call) / sizeof(call[0]));
 
-		if (ns.enable_side)
+		if (ping.enable)
 		{
-			--header.tab_cnt;
-			print_tab(header);
-			fwprintf(header.file, L"}");
-
-			if (ns.enable)
-			{
-				fwprintf(header.file, L"\n");
+			print_lines(header, pinged, sizeof(pinged) / sizeof(pinged[0]));
+		}
 
-				--header.tab_cnt;
-				print_tab(header);
-				fwprintf(header.file, L"}");
-			}
+		if (compress.enable)
+		{
+			print_lines(header, packed, sizeof(packed) / sizeof(packed[0]));
 		}
-		else if (ns.enable)
+
+		print_lines(header, tail, sizeof(tail) / sizeof(tail[0]));
+
+		if (integrity.enable)
 		{
-			--header.tab_cnt;
 			print_tab(header);
-			fwprintf(header.file, L"}");
+			fwprintf(header.file, L"\tchar scratch_[FRAME_CAPACITY];\n");
 		}
 
-		// cpp
+		print_tab(header);
+		fwprintf(header.file, L"};\n");
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"default:\n");
+		print_shared_close(header);
+	}
 
-		++cpp.tab_cnt;
-		if (logger.enable && dispatch.enable_weird_type)
+	void print_uring(FileInfo& header)
+	{
+		static const wchar_t* const head[] =
 		{
-			print_tab(cpp);
-			fwprintf(cpp.file, L"%s\n", dispatch.weird_type);
-		}
+			L"// Linux io_uring transport: multishot receive into a provided buffer ring, sends from registered fixed buffers",
+			L"template <typename Stub, typename Session>",
+			L"class UringTransport",
+			L"{",
+			L"public:",
+		};
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"return false;\n");
+		static const wchar_t* const body[] =
+		{
+			L"",
+			L"\tusing Dispatcher = StreamDispatcher<Stub, Session>;",
+			L"\tusing Closed = void (*)(Session* session);",
+			L"",
+			L"\t// a registered send buffer, encode frames into data and hand it to send()",
+			L"\tstruct SendBuffer",
+			L"\t{",
+			L"\t\tunsigned index;",
+			L"\t\tstd::span<std::byte> data;",
+			L"\t};",
+			L"",
+			L"\texplicit UringTransport(Stub& stub, Closed closed = nullptr) : stub_(stub), closed_(closed)",
+			L"\t{",
+			L"\t\tsize_t bytes = (2 * static_cast<size_t>(BUFFER_CNT) * BUFFER_SIZE + PAGE - 1) / PAGE * PAGE;",
+			L"\t\tmemory_ = static_cast<std::byte*>(std::aligned_alloc(PAGE, bytes));",
+			L"",
+			L"\t\tif (memory_ == nullptr)",
+			L"\t\t{",
+			L"\t\t\tthrow std::bad_alloc();",
+			L"\t\t}",
+			L"",
+			L"\t\t// the destructor never runs for a throwing constructor, so every failure undoes what came before it",
+			L"\t\tif (io_uring_queue_init(ENTRIES, &ring_, 0) < 0)",
+			L"\t\t{",
+			L"\t\t\tstd::free(memory_);",
+			L"\t\t\tthrow std::runtime_error(\"io_uring_queue_init failed\");",
+			L"\t\t}",
+			L"",
+			L"\t\tint ret = 0;",
+			L"\t\tbuffer_ring_ = io_uring_setup_buf_ring(&ring_, BUFFER_CNT, BUFFER_GROUP, 0, &ret);",
+			L"",
+			L"\t\tif (buffer_ring_ == nullptr)",
+			L"\t\t{",
+			L"\t\t\tio_uring_queue_exit(&ring_);",
+			L"\t\t\tstd::free(memory_);",
+			L"\t\t\tthrow std::runtime_error(\"io_uring buffer ring setup failed\");",
+			L"\t\t}",
+			L"",
+			L"\t\tfor (unsigned i = 0; i < BUFFER_CNT; ++i)",
+			L"\t\t{",
+			L"\t\t\tio_uring_buf_ring_add(buffer_ring_, recv_buffer(i), BUFFER_SIZE, static_cast<unsigned short>(i),",
+			L"\t\t\t\tio_uring_buf_ring_mask(BUFFER_CNT), static_cast<int>(i));",
+			L"\t\t}",
+			L"",
+			L"\t\tio_uring_buf_ring_advance(buffer_ring_, BUFFER_CNT);",
+			L"",
+			L"\t\t// registered once, fixed writes skip pinning the pages on every send",
+			L"\t\tstd::vector<iovec> iovecs(BUFFER_CNT);",
+			L"",
+			L"\t\tfor (unsigned i = 0; i < BUFFER_CNT; ++i)",
+			L"\t\t{",
+			L"\t\t\tiovecs[i].iov_base = send_buffer(i);",
+			L"\t\t\tiovecs[i].iov_len = BUFFER_SIZE;",
+			L"",
+			L"\t\t\tfree_sends_.push_back(BUFFER_CNT - 1 - i);",
+			L"\t\t}",
+			L"",
+			L"\t\tif (io_uring_register_buffers(&ring_, iovecs.data(), BUFFER_CNT) < 0)",
+			L"\t\t{",
+			L"\t\t\tio_uring_free_buf_ring(&ring_, buffer_ring_, BUFFER_CNT, BUFFER_GROUP);",
+			L"\t\t\tio_uring_queue_exit(&ring_);",
+			L"\t\t\tstd::free(memory_);",
+			L"\t\t\tthrow std::runtime_error(\"io_uring_register_buffers failed\");",
+			L"\t\t}",
+			L"",
+			L"\t\tsend_sizes_.resize(BUFFER_CNT);",
+			L"\t\tsend_offsets_.resize(BUFFER_CNT);",
+			L"\t\tsend_next_.resize(BUFFER_CNT);",
+			L"\t}",
+			L"",
+			L"\tUringTransport(const UringTransport&) = delete;",
+			L"\tUringTransport& operator=(const UringTransport&) = delete;",
+			L"",
+			L"\t~UringTransport()",
+			L"\t{",
+			L"\t\tfor (Connection& connection : connections_)",
+			L"\t\t{",
+			L"\t\t\tif (connection.fd >= 0)",
+			L"\t\t\t{",
+			L"\t\t\t\tclose(connection.fd);",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\tio_uring_free_buf_ring(&ring_, buffer_ring_, BUFFER_CNT, BUFFER_GROUP);",
+			L"\t\tio_uring_queue_exit(&ring_);",
+			L"",
+			L"\t\tstd::free(memory_);",
+			L"\t}",
+			L"",
+			L"\t// takes over a connected socket, its frames reach stub.dispatch() from poll()",
+			L"\tint attach(int fd, Session* session)",
+			L"\t{",
+			L"\t\tint id = static_cast<int>(connections_.size());",
+			L"",
+			L"\t\tfor (int i = 0; i < static_cast<int>(connections_.size()); ++i)",
+			L"\t\t{",
+			L"\t\t\tif (connections_[i].fd < 0)",
+			L"\t\t\t{",
+			L"\t\t\t\tid = i;",
+			L"\t\t\t\tbreak;",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\tConnection connection{ fd, session, Dispatcher(stub_, session), BUFFER_CNT, BUFFER_CNT, 0, false, false };",
+			L"",
+			L"\t\tif (id == static_cast<int>(connections_.size()))",
+			L"\t\t{",
+			L"\t\t\tconnections_.push_back(connection);",
+			L"\t\t}",
+			L"\t\telse",
+			L"\t\t{",
+			L"\t\t\tconnections_[id] = connection;",
+			L"\t\t}",
+			L"",
+			L"\t\tarm_recv(id);",
+			L"",
+			L"\t\treturn id;",
+			L"\t}",
+			L"",
+			L"\t// shuts the socket down, the session is reported to closed() once nothing is in flight",
+			L"\tvoid detach(int id)",
+			L"\t{",
+			L"\t\tConnection& connection = connections_[id];",
+			L"",
+			L"\t\tif (connection.fd >= 0 && !connection.closing)",
+			L"\t\t{",
+			L"\t\t\tconnection.closing = true;",
+			L"\t\t\tshutdown(connection.fd, SHUT_RDWR);",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\t// empty data when every send buffer is in flight",
+			L"\tSendBuffer acquire()",
+			L"\t{",
+			L"\t\tif (free_sends_.empty())",
+			L"\t\t{",
+			L"\t\t\treturn SendBuffer{ BUFFER_CNT, {} };",
+			L"\t\t}",
+			L"",
+			L"\t\tunsigned index = free_sends_.back();",
+			L"\t\tfree_sends_.pop_back();",
+			L"",
+			L"\t\treturn SendBuffer{ index, std::span<std::byte>(send_buffer(index), BUFFER_SIZE) };",
+			L"\t}",
+			L"",
+			L"\tvoid release(SendBuffer buffer)",
+			L"\t{",
+			L"\t\tfree_sends_.push_back(buffer.index);",
+			L"\t}",
+			L"",
+			L"\t// queues the first size bytes behind the connection's earlier sends, the buffer comes back to acquire() once written",
+			L"\tvoid send(int id, SendBuffer buffer, size_t size)",
+			L"\t{",
+			L"\t\tConnection& connection = connections_[id];",
+			L"",
+			L"\t\tif (connection.closing)",
+			L"\t\t{",
+			L"\t\t\trelease(buffer);",
+			L"\t\t\treturn;",
+			L"\t\t}",
+			L"",
+			L"\t\tsend_sizes_[buffer.index] = static_cast<unsigned>(size);",
+			L"\t\tsend_offsets_[buffer.index] = 0;",
+			L"\t\tsend_next_[buffer.index] = BUFFER_CNT;",
+			L"",
+			L"\t\t// one write in flight per connection, so frames leave in order and never interleave",
+			L"\t\tif (connection.send_tail == BUFFER_CNT)",
+			L"\t\t{",
+			L"\t\t\tconnection.send_head = buffer.index;",
+			L"\t\t\twrite_head(id);",
+			L"\t\t}",
+			L"\t\telse",
+			L"\t\t{",
+			L"\t\t\tsend_next_[connection.send_tail] = buffer.index;",
+			L"\t\t}",
+			L"",
+			L"\t\tconnection.send_tail = buffer.index;",
+			L"\t\t++connection.sends;",
+			L"\t}",
+			L"",
+			L"\t// submits queued work, waits for a completion and dispatches everything that has arrived",
+			L"\tvoid poll()",
+			L"\t{",
+			L"\t\tio_uring_submit_and_wait(&ring_, 1);",
+			L"",
+			L"\t\tio_uring_cqe* cqe;",
+			L"\t\tunsigned head;",
+			L"\t\tunsigned seen = 0;",
+			L"",
+			L"\t\tio_uring_for_each_cqe(&ring_, head, cqe)",
+			L"\t\t{",
+			L"\t\t\tcomplete(cqe);",
+			L"\t\t\t++seen;",
+			L"\t\t}",
+			L"",
+			L"\t\tio_uring_cq_advance(&ring_, seen);",
+			L"\t}",
+			L"",
+			L"private:",
+			L"\tstatic constexpr unsigned short BUFFER_GROUP = 0;",
+			L"\tstatic constexpr size_t PAGE = 4096;",
+			L"\tstatic constexpr unsigned long long RECV = 0;",
+			L"\tstatic constexpr unsigned long long SEND = 1;",
+			L"",
+			L"\tstruct Connection",
+			L"\t{",
+			L"\t\tint fd;",
+			L"\t\tSession* session;",
+			L"\t\tDispatcher dispatcher;",
+			L"\t\tunsigned send_head;",
+			L"\t\tunsigned send_tail;",
+			L"\t\tunsigned sends;",
+			L"\t\tbool receiving;",
+			L"\t\tbool closing;",
+			L"\t};",
+			L"",
+			L"\tstatic unsigned long long user_data(int id, unsigned long long kind, unsigned index)",
+			L"\t{",
+			L"\t\treturn (static_cast<unsigned long long>(id) << 32) | (static_cast<unsigned long long>(index) << 1) | kind;",
+			L"\t}",
+			L"",
+			L"\tstd::byte* recv_buffer(unsigned index)",
+			L"\t{",
+			L"\t\treturn memory_ + static_cast<size_t>(index) * BUFFER_SIZE;",
+			L"\t}",
+			L"",
+			L"\tstd::byte* send_buffer(unsigned index)",
+			L"\t{",
+			L"\t\treturn memory_ + static_cast<size_t>(BUFFER_CNT + index) * BUFFER_SIZE;",
+			L"\t}",
+			L"",
+			L"\tio_uring_sqe* get_sqe()",
+			L"\t{",
+			L"\t\tio_uring_sqe* sqe = io_uring_get_sqe(&ring_);",
+			L"",
+			L"\t\twhile (sqe == nullptr)",
+			L"\t\t{",
+			L"\t\t\tio_uring_submit(&ring_);",
+			L"\t\t\tsqe = io_uring_get_sqe(&ring_);",
+			L"\t\t}",
+			L"",
+			L"\t\treturn sqe;",
+			L"\t}",
+			L"",
+			L"\t// the rest of the oldest queued buffer, a short write resumes where it stopped",
+			L"\tvoid write_head(int id)",
+			L"\t{",
+			L"\t\tConnection& connection = connections_[id];",
+			L"\t\tunsigned index = connection.send_head;",
+			L"\t\tunsigned offset = send_offsets_[index];",
+			L"",
+			L"\t\tio_uring_sqe* sqe = get_sqe();",
+			L"\t\tio_uring_prep_write_fixed(sqe, connection.fd, send_buffer(index) + offset, send_sizes_[index] - offset, 0,",
+			L"\t\t\tstatic_cast<int>(index));",
+			L"\t\tio_uring_sqe_set_data64(sqe, user_data(id, SEND, index));",
+			L"\t}",
+			L"",
+			L"\tvoid arm_recv(int id)",
+			L"\t{",
+			L"\t\tio_uring_sqe* sqe = get_sqe();",
+			L"\t\tio_uring_prep_recv_multishot(sqe, connections_[id].fd, nullptr, 0, 0);",
+			L"\t\tsqe->flags |= IOSQE_BUFFER_SELECT;",
+			L"\t\tsqe->buf_group = BUFFER_GROUP;",
+			L"\t\tio_uring_sqe_set_data64(sqe, user_data(id, RECV, 0));",
+			L"",
+			L"\t\tconnections_[id].receiving = true;",
+			L"\t}",
+			L"",
+			L"\tvoid complete(io_uring_cqe* cqe)",
+			L"\t{",
+			L"\t\tunsigned long long data = io_uring_cqe_get_data64(cqe);",
+			L"\t\tint id = static_cast<int>(data >> 32);",
+			L"\t\tConnection& connection = connections_[id];",
+			L"",
+			L"\t\tif ((data & 1) == SEND)",
+			L"\t\t{",
+			L"\t\t\tunsigned index = static_cast<unsigned>(data >> 1) & 0x7FFFFFFF;",
+			L"",
+			L"\t\t\tif (cqe->res > 0)",
+			L"\t\t\t{",
+			L"\t\t\t\tsend_offsets_[index] += static_cast<unsigned>(cqe->res);",
+			L"\t\t\t}",
+			L"\t\t\telse",
+			L"\t\t\t{",
+			L"\t\t\t\tdetach(id);",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tif (!connection.closing && send_offsets_[index] < send_sizes_[index])",
+			L"\t\t\t{",
+			L"\t\t\t\twrite_head(id);",
+			L"\t\t\t\treturn;",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\t// a closing connection hands back everything still queued behind the head",
+			L"\t\t\tdo",
+			L"\t\t\t{",
+			L"\t\t\t\tindex = connection.send_head;",
+			L"\t\t\t\tconnection.send_head = send_next_[index];",
+			L"",
+			L"\t\t\t\tfree_sends_.push_back(index);",
+			L"\t\t\t\t--connection.sends;",
+			L"\t\t\t} while (connection.closing && connection.send_head != BUFFER_CNT);",
+			L"",
+			L"\t\t\tif (connection.send_head == BUFFER_CNT)",
+			L"\t\t\t{",
+			L"\t\t\t\tconnection.send_tail = BUFFER_CNT;",
+			L"\t\t\t}",
+			L"\t\t\telse",
+			L"\t\t\t{",
+			L"\t\t\t\twrite_head(id);",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"\t\telse",
+			L"\t\t{",
+			L"\t\t\tbool more = (cqe->flags & IORING_CQE_F_MORE) != 0;",
+			L"",
+			L"\t\t\tif (cqe->res > 0)",
+			L"\t\t\t{",
+			L"\t\t\t\tunsigned index = cqe->flags >> IORING_CQE_BUFFER_SHIFT;",
+			L"",
+			L"\t\t\t\tif (!connection.closing && !connection.dispatcher.feed(reinterpret_cast<const char*>(recv_buffer(index)), cqe->res))",
+			L"\t\t\t\t{",
+			L"\t\t\t\t\tdetach(id);",
+			L"\t\t\t\t}",
+			L"",
+			L"\t\t\t\tio_uring_buf_ring_add(buffer_ring_, recv_buffer(index), BUFFER_SIZE, static_cast<unsigned short>(index),",
+			L"\t\t\t\t\tio_uring_buf_ring_mask(BUFFER_CNT), 0);",
+			L"\t\t\t\tio_uring_buf_ring_advance(buffer_ring_, 1);",
+			L"\t\t\t}",
+			L"\t\t\telse if (cqe->res != -ENOBUFS)",
+			L"\t\t\t{",
+			L"\t\t\t\tdetach(id);",
+			L"\t\t\t}",
+			L"",
+			L"\t\t\tconnection.receiving = more;",
+			L"",
+			L"\t\t\t// ran dry of ring buffers or hit a one-off stop, keep receiving",
+			L"\t\t\tif (!more && !connection.closing)",
+			L"\t\t\t{",
+			L"\t\t\t\tarm_recv(id);",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"",
+			L"\t\tif (connection.closing && !connection.receiving && connection.sends == 0 && connection.fd >= 0)",
+			L"\t\t{",
+			L"\t\t\tclose(connection.fd);",
+			L"\t\t\tconnection.fd = -1;",
+			L"",
+			L"\t\t\tif (closed_ != nullptr)",
+			L"\t\t\t{",
+			L"\t\t\t\tclosed_(connection.session);",
+			L"\t\t\t}",
+			L"\t\t}",
+			L"\t}",
+			L"",
+			L"\tStub& stub_;",
+			L"\tClosed closed_;",
+			L"\tio_uring ring_;",
+			L"\tio_uring_buf_ring* buffer_ring_ = nullptr;",
+			L"\tstd::byte* memory_ = nullptr;",
+			L"\tstd::vector<unsigned> free_sends_;",
+			L"\tstd::vector<unsigned> send_sizes_;",
+			L"\tstd::vector<unsigned> send_offsets_;",
+			L"\tstd::vector<unsigned> send_next_;",
+			L"\tstd::vector<Connection> connections_;",
+			L"};",
+		};
 
-		--cpp.tab_cnt;
+		fwprintf(header.file, L"#pragma once\n\n");
+		fwprintf(header.file, L"#include \"%s\"\n\n", stm.filename);
+		fwprintf(header.file, L"#include <liburing.h>\n#include <sys/socket.h>\n#include <unistd.h>\n\n");
+		fwprintf(header.file, L"#include <cerrno>\n#include <cstddef>\n#include <cstdlib>\n#include <new>\n#include <span>\n#include <stdexcept>\n#include <vector>\n\n");
 
-		print_tab(cpp);
-		fwprintf(cpp.file, L"}\n"); // switch
+		print_shared_namespace(header);
 
-		if (try_catch.enable)
-		{
-			--cpp.tab_cnt;
+		print_lines(header, head, sizeof(head) / sizeof(head[0]));
 
-			print_tab(cpp);
-			fwprintf(cpp.file, L"}\n"); // try
+		print_tab(header);
+		fwprintf(header.file, L"\tstatic constexpr unsigned ENTRIES = %d;\n", uring.entries);
 
-			print_tab(cpp);
-			fwprintf(cpp.file, L"catch (const %s& e)\n", try_catch.type);
+		print_tab(header);
+		fwprintf(header.file, L"\tstatic constexpr unsigned BUFFER_CNT = %d;\n", uring.buffer_cnt);
 
-			print_tab(cpp);
-			fwprintf(cpp.file, L"{\n");
+		print_tab(header);
+		fwprintf(header.file, L"\tstatic constexpr size_t BUFFER_SIZE = %d;\n", uring.buffer_size);
 
-			++cpp.tab_cnt;
+		print_lines(header, body, sizeof(body) / sizeof(body[0]));
 
-			if (logger.enable && dispatch.enable_exception)
-			{
-				print_tab(cpp);
-				fwprintf(cpp.file, L"%s\n", dispatch.exception);
-			}
+		print_shared_close(header);
+	}
 
-			print_tab(cpp);
-			fwprintf(cpp.file, L"return false;\n");
+	bool is_stub_of(const Protocol& info, int s_c)
+	{
+		return (info.name[0] == L'S') == (s_c == CLIENT);
+	}
 
-			--cpp.tab_cnt;
-			print_tab(cpp);
-			fwprintf(cpp.file, L"}\n"); // catch
+	// small payloads are never worth packing, so encoders below the threshold skip it entirely
+	bool is_packed(const Protocol& info)
+	{
+		return compress.enable && info.compress && info.max_size > compress.threshold;
+	}
+
+	bool is_batched(const Protocol& info)
+	{
+		return batch.enable && info.batch;
+	}
+
+	bool is_batch_side(int s_c)
+	{
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			if (is_stub_of(protocols[i], s_c) && is_batched(protocols[i]))
+			{
+				return true;
+			}
 		}
 
-		--cpp.tab_cnt;
-		print_tab(cpp);
-		fwprintf(cpp.file, L"}\n"); // dispatch
+		return false;
+	}
 
-		if (ns.enable_side)
+	bool is_batch_encoded(const Protocol& info)
+	{
+		return batch_encode.enable && info.batch;
+	}
+
+	// same proxy, parameter types and packing, so the encoder bodies differ only in the type
+	bool is_same_shape(const Protocol& a, const Protocol& b)
+	{
+		if (a.name[0] != b.name[0] || a.param_cnt != b.param_cnt || is_packed(a) != is_packed(b))
 		{
-			--cpp.tab_cnt;
-			print_tab(cpp);
-			fwprintf(cpp.file, L"}");
+			return false;
+		}
 
-			if (ns.enable)
+		for (int i = 0; i < a.param_cnt; ++i)
+		{
+			if (wcscmp(a.param_type[i], b.param_type[i]) != 0 || a.param_length[i] != b.param_length[i])
 			{
-				fwprintf(cpp.file, L"\n");
-
-				--cpp.tab_cnt;
-				print_tab(cpp);
-				fwprintf(cpp.file, L"}");
+				return false;
 			}
 		}
-		else if (ns.enable)
+
+		return true;
+	}
+
+	bool has_string(const Protocol& info)
+	{
+		for (int i = 0; i < info.param_cnt; ++i)
 		{
-			--cpp.tab_cnt;
-			print_tab(cpp);
-			fwprintf(cpp.file, L"}");
+			if (info.param_length[i] > 0)
+			{
+				return true;
+			}
 		}
+
+		return false;
 	}
 
-	void print_close_proxy(FileInfo& header, FileInfo& cpp)
+	// name appears as a whole identifier, so a cold function can leave an unused parameter unnamed
+	bool is_used(const wchar_t* expression, const wchar_t* name)
 	{
-		--header.tab_cnt;
-		print_tab(header);
-		fwprintf(header.file, L"};\n"); // class
+		size_t len = wcslen(name);
 
-		if (ns.enable_side)
+		for (const wchar_t* found = wcsstr(expression, name); found != nullptr; found = wcsstr(found + 1, name))
 		{
-			--header.tab_cnt;
-			print_tab(header);
-			fwprintf(header.file, L"}");
-
-			--cpp.tab_cnt;
-			print_tab(cpp);
-			fwprintf(cpp.file, L"}");
+			bool before = found > expression && (iswalnum(found[-1]) || found[-1] == L'_');
+			bool after = iswalnum(found[len]) || found[len] == L'_';
 
-			if (ns.enable)
+			if (!before && !after)
 			{
-				fwprintf(header.file, L"\n");
-
-				--header.tab_cnt;
-				print_tab(header);
-				fwprintf(header.file, L"}");
+				return true;
+			}
+		}
 
-				fwprintf(cpp.file, L"\n");
+		return false;
+	}
 
-				--cpp.tab_cnt;
-				print_tab(cpp);
-				fwprintf(cpp.file, L"}");
+	// a side's decoders also take the payload size once any of its messages carries a string
+	bool is_sized(int s_c)
+	{
+		for (int i = 0; i < protocol_cnt; ++i)
+		{
+			if (is_stub_of(protocols[i], s_c) && has_string(protocols[i]))
+			{
+				return true;
 			}
 		}
-		else if (ns.enable)
-		{
-			--header.tab_cnt;
-			print_tab(header);
-			fwprintf(header.file, L"}");
 
-			--cpp.tab_cnt;
-			print_tab(cpp);
-			fwprintf(cpp.file, L"}");
+		return false;
+	}
+
+	// anything print_dispatch_cold would move out of dispatch
+	bool has_cold_path()
+	{
+		if (!layout.enable)
+		{
+			return false;
 		}
+
+		bool log_size = dispatch.enable_bad_size && decode.enable;
+		bool log_exception = dispatch.enable_exception && try_catch.enable && !decode.enable;
+
+		return cold_case_cnt > 0 || (logger.enable && (dispatch.enable_weird_type || log_size || log_exception));
 	}
 
-	void print_tab(FileInfo& info)
+	// a side none of whose incoming messages carries [rate = n] dispatches without the lookup
+	bool is_rated(int s_c)
 	{
-		for (int i = 0; i < info.tab_cnt; ++i)
+		for (int i = 0; i < protocol_cnt && rate_limit.enable; ++i)
 		{
-			fwprintf(info.file, L"\t");
+			if (is_stub_of(protocols[i], s_c) && protocols[i].rate_slot != -1)
+			{
+				return true;
+			}
 		}
+
+		return false;
 	}
 }
 
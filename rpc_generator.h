@@ -6,8 +6,18 @@ namespace rpc
 {
 	constexpr int BUFFER_SIZE = 64;
 
+	constexpr int EXPRESSION_SIZE = 256;
+
+	constexpr int LIST_SIZE = 1024;
+
 	constexpr int MAX_PARAMETER_CNT = 16;
 
+	constexpr int MAX_FRAME_SIZE = 4 + 255 + 4; // widest header, payload and trailer
+
+	constexpr int MAX_PROTOCOL_CNT = 1024;
+
+	constexpr int MAX_TYPE_MAP_CNT = 32;
+
 	constexpr int SERVER = 0;
 	constexpr int CLIENT = 1;
 	constexpr wchar_t RPC_SIDE[2][8] = { L"server",L"client" };
@@ -22,6 +32,23 @@ namespace rpc
 	constexpr wchar_t EXTENSION[2][8] = { L".h",L".cpp" };
 
 	constexpr wchar_t CODE_VALUE[] = L"0x89";
+	constexpr int TRAILER_SIZE = 4;
+	constexpr wchar_t COMPRESSED_CODE_VALUE[] = L"0x8B"; // CODE_VALUE with the packed-payload bit set
+
+	constexpr int PRIORITY_HIGH = 0;
+	constexpr int PRIORITY_NORMAL = 1;
+	constexpr int PRIORITY_LOW = 2;
+	constexpr wchar_t PRIORITY_NAME[3][8] = { L"HIGH",L"NORMAL",L"LOW" };
+
+	constexpr int ENTRY_HANDLER = 0;
+	constexpr int ENTRY_DECODER = 1;
+	constexpr int ENTRY_SIZE = 2;
+	constexpr int ENTRY_RATE = 3;
+
+	constexpr int TIER_WARM = 0;
+	constexpr int TIER_HOT = 1;
+	constexpr int TIER_COLD = 2;
+	constexpr int MAX_HOT_CASE = 4; // compares before the switch, past that a jump table wins
 
 	struct Creation
 	{
@@ -53,16 +80,157 @@ namespace rpc
 	struct Profiler
 	{
 		wchar_t header[BUFFER_SIZE];
-		wchar_t expression[BUFFER_SIZE];
+		wchar_t expression[EXPRESSION_SIZE];
 		bool enable;
 	};
 
 	struct Dispatch
 	{
-		wchar_t weird_type[BUFFER_SIZE];
-		wchar_t exception[BUFFER_SIZE];
+		wchar_t weird_type[EXPRESSION_SIZE];
+		wchar_t exception[EXPRESSION_SIZE];
+		wchar_t bad_size[EXPRESSION_SIZE];
 		bool enable_weird_type;
 		bool enable_exception;
+		bool enable_bad_size;
+	};
+
+	struct Decode
+	{
+		bool string_test;
+		bool enable;
+	};
+
+	struct ShardDispatch
+	{
+		int batch;
+		bool enable;
+	};
+
+	struct BatchDispatch
+	{
+		int capacity;
+		bool enable;
+	};
+
+	struct Coroutine
+	{
+		int block_size;
+		bool enable;
+	};
+
+	struct Layout
+	{
+		wchar_t profile[BUFFER_SIZE];
+		int hot; // percent of the profiled traffic
+		int cold; // parts per million
+		bool enable;
+	};
+
+	struct ProfileEntry
+	{
+		wchar_t name[BUFFER_SIZE]; // message name or decimal type
+		double count;
+		bool used;
+	};
+
+	struct View
+	{
+		bool enable;
+	};
+
+	struct Traits
+	{
+		bool enable;
+	};
+
+	struct Compress
+	{
+		int threshold; // payload bytes
+		bool enable;
+	};
+
+	struct Trace
+	{
+		wchar_t provider[BUFFER_SIZE]; // USDT provider
+		wchar_t prefix[BUFFER_SIZE]; // provider in upper case, starts every macro
+		bool enable;
+	};
+
+	struct RateLimit
+	{
+		bool disconnect; // a flood frame fails dispatch instead of being dropped
+		bool enable;
+	};
+
+	struct Integrity
+	{
+		int trailer_size; // TRAILER_SIZE when enabled, 0 otherwise
+		bool enable;
+	};
+
+	struct ProxyCode
+	{
+		bool inline_body;
+		bool shared; // messages of one wire shape call a shared body with their type
+	};
+
+	struct Gather
+	{
+		int chunk_size;
+		bool enable;
+	};
+
+	struct SendQueue
+	{
+		int batch;
+		bool enable;
+	};
+
+	struct BatchEncode
+	{
+		bool test;
+		bool enable;
+	};
+
+	struct Uring
+	{
+		int entries;
+		int buffer_cnt;
+		int buffer_size;
+		bool enable;
+	};
+
+	struct Ping
+	{
+		int request_type; // wire types kept out of protocol.txt
+		int reply_type;
+		bool enable;
+	};
+
+	struct Bot
+	{
+		wchar_t request[BUFFER_SIZE]; // latency probe, the reply carries its first parameter back
+		wchar_t reply[BUFFER_SIZE];
+		int port;
+		int clients;
+		int seconds;
+		int rate; // messages per client per second
+		bool enable;
+	};
+
+	struct Loopback
+	{
+		wchar_t request[BUFFER_SIZE]; // answered by the server stub, the reply carries its first parameter back
+		wchar_t reply[BUFFER_SIZE];
+		int messages;
+		int ring; // bytes per direction
+		bool enable;
+	};
+
+	struct Outbox
+	{
+		int drop_threshold;
+		bool enable;
 	};
 
 	struct SerialBuffer
@@ -70,6 +238,16 @@ namespace rpc
 		wchar_t header[BUFFER_SIZE];
 		wchar_t type[BUFFER_SIZE];
 		wchar_t param[BUFFER_SIZE];
+		wchar_t put_data[BUFFER_SIZE];
+	};
+
+	struct TypeMap
+	{
+		wchar_t from[MAX_TYPE_MAP_CNT][BUFFER_SIZE];
+		wchar_t to[MAX_TYPE_MAP_CNT][BUFFER_SIZE];
+		int cnt;
+		bool forward_declare;
+		bool enable;
 	};
 
 	struct Session
@@ -81,14 +259,42 @@ namespace rpc
 		bool side_prefix;
 	};
 
+	struct TypeId
+	{
+		wchar_t name[BUFFER_SIZE];
+		int bits;
+		int max;
+		int header_size;
+	};
+
 	struct Protocol
 	{
 		wchar_t name[BUFFER_SIZE];
 		wchar_t lower_name[BUFFER_SIZE];
+		wchar_t class_name[BUFFER_SIZE];
 		wchar_t param_type[MAX_PARAMETER_CNT][BUFFER_SIZE];
 		wchar_t param_name[MAX_PARAMETER_CNT][BUFFER_SIZE];
+		int param_size[MAX_PARAMETER_CNT]; // bytes per character for strings
+		int param_length[MAX_PARAMETER_CNT]; // N of string<N> or wstring<N>, 0 for scalars
 		int protocol_type;
 		int param_cnt;
+		int min_size;
+		int max_size;
+		wchar_t coalesce_by[BUFFER_SIZE];
+		wchar_t coalesce_group[BUFFER_SIZE];
+		int coalesce_param;
+		int group_id;
+		int priority;
+		bool droppable;
+		bool compress;
+		bool batch; // decoded into columns for a batch handler, set when dispatch.batch
+		int weight; // share of the bot mix
+		int rate; // messages per second, 0 when unlimited
+		int burst;
+		int rate_slot; // dense index into RATE_LIMIT, -1 when unlimited
+		int shape_id; // shared encoder, set when proxy.shared
+		double traffic; // count from dispatch.layout.profile
+		int tier;
 	};
 
 	struct FileInfo